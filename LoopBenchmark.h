@@ -0,0 +1,83 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <iostream>
+
+#include "include/Socket.h"
+
+// measures what the receive loop costs per read on loopback, once with the handler inlined into the loop
+// and once type erased through a std::function like the loop used to take it
+class LoopBenchmark
+{
+    using Clock = std::chrono::steady_clock;
+    using LoopHandler = std::function<bool(char*&, size_t&, size_t, size_t&)>;
+
+    uint16_t port;
+    size_t readSize;
+    size_t totalBytes;
+
+    struct Result {
+        size_t reads = 0;
+        double seconds = 0;
+    };
+
+    // the peer writes totalBytes in large blocks, the loop reads them back readSize at a time,
+    // every run listens on its own port so the previous one's TIME_WAIT doesn't block the bind
+    template<typename Run>
+    Result measure(uint16_t port, Run&& run) {
+        Network::Socket listener;
+        listener.bind(port, "127.0.0.1");
+        listener.listen();
+
+        std::thread writer([this, port]() {
+            Network::Socket peer;
+            peer.connect("127.0.0.1", port);
+            std::vector<char> block(256 * 1024, 'x');
+            for (size_t sent = 0; sent < totalBytes; sent += block.size())
+                peer.sendCommited(block.data(), std::min(block.size(), totalBytes - sent), 5);
+        });
+
+        Network::Socket client = listener.accept();
+        std::vector<char> buffer(readSize);
+        Result result;
+
+        auto start = Clock::now();
+        run(client, buffer, result.reads);
+        result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        writer.join();
+        return result;
+    }
+
+    void report(const char* name, const Result& result) {
+        std::cout << name << ": " << result.reads << " reads in " << result.seconds << "s, "
+            << result.seconds * 1e9 / std::max<size_t>(result.reads, 1) << " ns/read" << std::endl;
+    }
+
+public:
+    LoopBenchmark(uint16_t port = 18090, size_t readSize = 64, size_t totalBytes = 64 * 1024 * 1024) :
+        port(port), readSize(readSize), totalBytes(totalBytes) {}
+
+    void run() {
+        auto inlined = measure(port, [this](Network::Socket& client, std::vector<char>& buffer, size_t& reads) {
+            client.receiveLoop(buffer.data(), buffer.size(), 0, 5,
+                [this, &reads](char*&, size_t&, size_t, size_t& receivedTotal) {
+                    reads++;
+                    return receivedTotal < totalBytes;
+                });
+        });
+
+        auto erased = measure(port + 1, [this](Network::Socket& client, std::vector<char>& buffer, size_t& reads) {
+            LoopHandler handler = [this, &reads](char*&, size_t&, size_t, size_t& receivedTotal) {
+                reads++;
+                return receivedTotal < totalBytes;
+            };
+            client.receiveLoop(buffer.data(), buffer.size(), 0, 5, handler);
+        });
+
+        report("inlined handler", inlined);
+        report("std::function handler", erased);
+    }
+};
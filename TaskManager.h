@@ -41,8 +41,8 @@ class TaskManager
         server.addEndpoint("/tasks", Network::HTTP::Request::Method::Post,
             [this](Network::HTTP::Request& req,
                 std::span<std::string_view> params) -> std::unique_ptr<Network::HTTP::Response> {
-                    auto length = std::stoi(req.getHeaders().get(
-                        Network::HTTP::Message::Headers::Standard::ContentLength));
+                    auto length = std::stoi(std::string(req.getHeaders().get(
+                        Network::HTTP::Message::Headers::Standard::ContentLength)));
                     auto& reqBody = req.getBody();
                     std::string bodyStr(length, '\0');
                     reqBody->read(bodyStr.data(), 0, length);
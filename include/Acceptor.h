@@ -12,22 +12,71 @@ private:
 
 	IOContext& m_acceptIOContext;
 	int m_port;
+	std::string m_path; // unix domain listeners only
+	Network::Socket::Profile m_clientProfile;
+
+	// readiness driven backends keep one accept loop running, asyncAccept calls after the first only replace the callback
+	std::mutex m_callbackMutex;
+	std::function<void(Network::Socket&&)> m_loopCallback;
+	bool m_loopArmed = false;
+
+	// pending retry after an accept error, cancelled with the acceptor
+	TimerWheel::Id m_retryTimer;
 
 
 public:
-	Acceptor(IOContext& context, int port) : 
-	m_acceptIOContext(context), m_port(port), m_acceptSocket()
+	// reusePort lets several acceptors share the port, each with its own context
+	Acceptor(IOContext& context, int port, bool reusePort = false) : 
+	m_acceptSocket(), m_acceptIOContext(context), m_port(port)
 	{
+		if (reusePort)
+			m_acceptSocket.setReusePort();
 		m_acceptSocket.bind(port);
 		m_acceptSocket.listen();
+		if (m_acceptIOContext.hasReactor())
+			m_acceptSocket.setNonBlocking();
+	}
+	// unix domain listener on a filesystem path or an '@' abstract name, skips the tcp stack for same host clients
+	Acceptor(IOContext& context, std::string_view path) :
+	m_acceptSocket(Network::Socket::Domain::Unix), m_acceptIOContext(context), m_port(0), m_path(path)
+	{
+		m_acceptSocket.bind(path);
+		m_acceptSocket.listen();
+		if (m_acceptIOContext.hasReactor())
+			m_acceptSocket.setNonBlocking();
 	}
+
+	// maps connections to acceptors by the cpu that received them, call on one acceptor once the whole group is bound
+	void steerByCpu(uint32_t groupSize) {
+		m_acceptSocket.setReusePortCpuSteering(groupSize);
+	}
+
+	// listener fields and the ones clients inherit take effect right away, the rest on every client accepted afterwards
+	void setProfile(const Network::Socket::Profile& profile) {
+		m_acceptSocket.applyProfile(profile, true);
+		m_clientProfile = m_acceptSocket.clientProfile(profile);
+	}
+
 	~Acceptor() {
+		m_acceptIOContext.cancelTimer(m_retryTimer);
+		m_acceptIOContext.cancel(m_acceptSocket);
 		m_acceptSocket.close();
+
+		std::error_code error;
+		if (!m_path.empty() && !Network::Socket::isAbstractPath(m_path))
+			std::filesystem::remove(m_path, error);
 	};
 
+	// clients of readiness driven backends are always non-blocking and timeouts are left to the backend
 	void asyncAccept(std::function<void(Network::Socket&&)> acceptCallback,
 		int clientTimeout = 30, bool clientNonBlocking = true)
 	{
+		if (m_acceptIOContext.hasReactor())
+		{
+			asyncAcceptLoop(std::move(acceptCallback));
+			return;
+		}
+
 		m_acceptIOContext.post([this,
 			callback = std::move(acceptCallback),
 			clientTimeout = clientTimeout,
@@ -37,11 +86,14 @@ public:
 					client
 						.setNonBlocking(clientNonBlocking)
 						.setTimeout(std::chrono::seconds(clientTimeout));
+					applyProfile(client);
 					m_acceptIOContext.postAcceptCallback(std::move(client), callback);
 				}
 				catch (const std::exception& e) {
-					// If accept failed, repost the accept operation
-					asyncAccept(std::move(callback), clientTimeout, clientNonBlocking);
+					// If accept failed, repost the accept operation once the backoff passed
+					retryLater([this, callback, clientTimeout, clientNonBlocking]() {
+						asyncAccept(callback, clientTimeout, clientNonBlocking);
+						});
 
 					// Optionally log the error
 					 std::cerr << "Accept error: " << e.what() << std::endl;
@@ -49,5 +101,84 @@ public:
 			});
 		
 	}
-};
 
+	static constexpr size_t s_maxAcceptBatch = 64; //bounds one drain so a connection storm can't starve other pool work
+	static constexpr std::chrono::milliseconds s_acceptRetryDelay{ 100 }; //pause after an accept error other than would block
+
+private:
+	void asyncAcceptLoop(std::function<void(Network::Socket&&)> acceptCallback)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_callbackMutex);
+			m_loopCallback = std::move(acceptCallback);
+			if (std::exchange(m_loopArmed, true))
+				return;
+		}
+
+		if (m_acceptIOContext.hasUring())
+			acceptMultishot();
+		else
+			waitForClients();
+	}
+
+	// a client the options can't be applied to is still served with kernel defaults
+	void applyProfile(Network::Socket& client)
+	{
+		try {
+			client.applyProfile(m_clientProfile);
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Socket profile error: " << e.what() << std::endl;
+		}
+	}
+
+	// EMFILE, ENFILE and ENOBUFS leave the listener readable, retrying right away would spin until a descriptor frees up
+	void retryLater(std::function<void()> retry)
+	{
+		m_retryTimer = m_acceptIOContext.setTimer(s_acceptRetryDelay, std::move(retry));
+	}
+
+	std::function<void(Network::Socket&&)> getLoopCallback()
+	{
+		std::lock_guard<std::mutex> lock(m_callbackMutex);
+		return m_loopCallback;
+	}
+
+	// one pool task per wakeup drains the whole backlog, the wait is rearmed afterwards
+	void waitForClients()
+	{
+		m_acceptIOContext.asyncWait(m_acceptSocket, Reactor::Event::Read, [this](bool) {
+			std::vector<Network::Socket> clients;
+			try {
+				m_acceptSocket.acceptBatch(clients, s_maxAcceptBatch);
+			}
+			catch (const std::exception& e) {
+				std::cerr << "Accept error: " << e.what() << std::endl;
+				retryLater([this]() { waitForClients(); });
+				return;
+			}
+			for (auto& client : clients)
+				applyProfile(client);
+
+			if (!clients.empty())
+				m_acceptIOContext.postAcceptCallbacks(std::move(clients), getLoopCallback());
+			waitForClients();
+		});
+	}
+
+	// the kernel keeps accepting after the first request, every handle is already non-blocking
+	void acceptMultishot()
+	{
+		m_acceptIOContext.getUring().asyncAccept(m_acceptSocket.getHandle(),
+			[this](Network::Socket::Handle handle) {
+				try {
+					auto client = Network::Socket::fromHandle(handle, true);
+					applyProfile(client);
+					m_acceptIOContext.postAcceptCallback(std::move(client), getLoopCallback());
+				}
+				catch (const std::exception& e) {
+					std::cerr << "Accept error: " << e.what() << std::endl;
+				}
+			});
+	}
+};
\ No newline at end of file
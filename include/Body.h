@@ -14,6 +14,9 @@ namespace Network::HTTP {
 
     protected:
         size_t m_size = 0;
+
+        //how much readChunked asks the socket for at once
+        static constexpr size_t s_chunkedReceiveSize = 1024 * 16;
     public:
         virtual ~Body() = default;
 
@@ -32,8 +35,9 @@ namespace Network::HTTP {
 
         virtual size_t readTransferSize(Socket& sock, std::string& leftovers,
             size_t size, size_t maxRetryCount, size_t maxBodySize) = 0;
-        virtual size_t readChunked(Socket& sock, std::string& leftovers,
-            size_t maxRetryCount, size_t maxBodySize) = 0;
+        // the same for every body, the payload goes through append(), what follows the body stays in leftovers
+        size_t readChunked(Socket& sock, std::string& leftovers,
+            size_t maxRetryCount, size_t maxBodySize);
 
         virtual size_t sendTransferSize(Socket& sock, size_t size,
             size_t maxRetryCount, size_t maxBodySize) = 0;
@@ -67,10 +71,10 @@ namespace Network::HTTP {
 
         const char* data() const { return m_data.data(); }
 
+        std::string_view view() const { return m_data; }
+
         virtual size_t readTransferSize(Socket& sock, std::string& leftovers,
             size_t size, size_t maxRetryCount, size_t maxBodySize) override;
-        virtual size_t readChunked(Socket& sock, std::string& leftovers,
-            size_t maxRetryCount, size_t maxBodySize) override;
 
         virtual size_t sendTransferSize(Socket& sock, size_t size,
             size_t maxRetryCount, size_t maxBodySize) override;
@@ -83,6 +87,9 @@ namespace Network::HTTP {
     private:
         mutable std::fstream m_file;
         std::string m_path;
+        int m_fileHandle = -1; //read only descriptor the kernel sends from, linux only
+
+        void openHandle();
 
     public:
         explicit FileBody(const std::string& path)
@@ -90,8 +97,11 @@ namespace Network::HTTP {
             m_file.open(path, std::ios::binary | std::ios::in | std::ios::out | std::ios::app);
             if (!m_file) throw std::runtime_error("Cannot open file buffer");
             m_size = std::filesystem::file_size(path);
+            openHandle();
         }
 
+        ~FileBody() override;
+
         size_t read(char* dest, size_t offset, size_t length) const override {
             if (offset >= m_size) return 0;
             m_file.seekg(offset);
@@ -121,8 +131,6 @@ namespace Network::HTTP {
 
         virtual size_t readTransferSize(Socket& sock, std::string& leftovers,
             size_t size, size_t maxRetryCount, size_t maxBodySize) override;
-        virtual size_t readChunked(Socket& sock, std::string& leftovers,
-            size_t maxRetryCount, size_t maxBodySize) override;
 
         virtual size_t sendTransferSize(Socket& sock, size_t size,
             size_t maxRetryCount, size_t maxBodySize) override;
@@ -0,0 +1,44 @@
+#pragma once
+#include "Body.h"
+
+namespace Network::HTTP
+{
+    // resumable decoder for a chunked transfer coding, shared by the blocking and the coroutine readers
+    // decode() gets the bytes buffered so far and reports how many of them it used up, whatever follows the
+    // last chunk and its trailers (the next pipelined message) is never touched
+    // payloads are handed to the body by length in as few appends as the receives allow, only the size
+    // and trailer lines are searched, so a chunk's bytes are copied once from the receive buffer into the body
+    class ChunkedDecoder
+    {
+        enum class State {
+            Size,      // chunk size line, extensions after ';' are ignored
+            Data,      // payload bytes still owed by the current chunk
+            DataEnd,   // CRLF closing the payload
+            Trailers,  // trailer fields up to the empty line, skipped
+            Complete
+        };
+
+        State m_state = State::Size;
+        size_t m_remaining = 0; // of the current chunk's payload
+        size_t m_bodySize = 0;
+        size_t m_trailerSize = 0;
+        size_t m_maxBodySize;
+
+        void parseSizeLine(std::string_view line);
+
+    public:
+        // a size line with its extensions longer than this is an attack or garbage, not a chunk header
+        static constexpr size_t s_maxSizeLineLength = 4096;
+
+        explicit ChunkedDecoder(size_t maxBodySize = s_maxBodySize) : m_maxBodySize(maxBodySize) {}
+
+        // appends the payload in data to body, returns the bytes consumed, the caller drops them from its buffer
+        // an incomplete line stays unconsumed until more arrives, throws on a malformed or oversized body
+        size_t decode(std::string_view data, Body& body);
+
+        bool isComplete() const { return m_state == State::Complete; }
+
+        // decoded payload bytes so far
+        size_t getBodySize() const { return m_bodySize; }
+    };
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "Common.h"
+
+// unbounded fifo any thread can push to and a single consumer drains in batches (vyukov's mpsc list),
+// the consumer sleeps on an atomic wait, a futex on linux, and only a push that finds it asleep pays for the wakeup
+template<typename T>
+class CompletionQueue
+{
+	struct Node
+	{
+		std::atomic<Node*> next = nullptr;
+		std::optional<T> value;
+	};
+
+	alignas(64) std::atomic<Node*> m_head; // last pushed node, producers swap themselves in here
+	alignas(64) Node* m_tail;              // already consumed node, its successor is the oldest item
+
+	std::atomic<uint32_t> m_epoch = 0;
+	std::atomic<bool> m_waiting = false;
+
+public:
+	CompletionQueue() {
+		m_tail = new Node();
+		m_head = m_tail;
+	}
+
+	~CompletionQueue() {
+		while (m_tail != nullptr)
+			delete std::exchange(m_tail, m_tail->next.load(std::memory_order_relaxed));
+	}
+
+	CompletionQueue(const CompletionQueue&) = delete;
+	CompletionQueue& operator=(const CompletionQueue&) = delete;
+
+	void push(T&& value) {
+		auto node = new Node();
+		node->value.emplace(std::move(value));
+
+		// seq_cst pairs with the consumer's announcement in waitForWork, one of the two sees the other
+		Node* previous = m_head.exchange(node, std::memory_order_seq_cst);
+		previous->next.store(node, std::memory_order_release);
+
+		if (m_waiting.load(std::memory_order_seq_cst))
+			wake();
+	}
+
+	void wake() {
+		m_epoch.fetch_add(1, std::memory_order_release);
+		m_epoch.notify_one();
+	}
+
+	// consumer only, moves up to maxCount items into out in push order, returns how many
+	size_t drain(std::vector<T>& out, size_t maxCount) {
+		size_t count = 0;
+		while (count < maxCount) {
+			Node* next = m_tail->next.load(std::memory_order_acquire);
+			if (next == nullptr)
+				break;
+
+			out.push_back(std::move(*next->value));
+			next->value.reset();
+			delete std::exchange(m_tail, next);
+			count++;
+		}
+		return count;
+	}
+
+	// consumer only, a producer may have swapped itself in without linking yet, drain sees it a moment later
+	bool empty() const {
+		return m_head.load(std::memory_order_seq_cst) == m_tail;
+	}
+
+	// consumer only, sleeps until something is pushed or wake is called
+	void waitForWork() {
+		auto epoch = m_epoch.load(std::memory_order_acquire);
+		m_waiting.store(true, std::memory_order_seq_cst);
+		if (empty())
+			m_epoch.wait(epoch, std::memory_order_acquire);
+		else
+			std::this_thread::yield(); // a push is halfway linked
+		m_waiting.store(false, std::memory_order_relaxed);
+	}
+};
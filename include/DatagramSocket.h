@@ -0,0 +1,81 @@
+#pragma once
+#include "Common.h"
+#include "Socket.h"
+#include "IOContext.h"
+
+namespace Network {
+
+    // udp socket that moves many datagrams per syscall (recvmmsg/sendmmsg), optionally with segmentation
+    // offload so one slot stands for many datagrams on the wire (linux only)
+    class DatagramSocket : public Socket {
+    public:
+        static constexpr size_t s_defaultSlotSize = 2048;       // fits a datagram of an ethernet mtu
+        static constexpr size_t s_maxSegmentedSize = 65535;     // slot size that takes a full gro/gso buffer
+        static constexpr size_t s_maxBatchSize = 1024;          // UIO_MAXIOV, the kernel caps one call here
+        static constexpr size_t s_maxBatchesPerWakeup = 16;     // asyncReceive yields the pool thread after this many
+        static constexpr std::chrono::seconds s_idleWait{ 1 };  // asyncReceive without a reactor polls this long per empty read
+
+        // preallocated slots for one batched call, reused across calls so the hot path never allocates
+        class Batch {
+        private:
+            friend class DatagramSocket;
+
+            struct Native; // mmsghdr/iovec/address/control arrays
+            std::unique_ptr<Native> m_native;
+            size_t m_capacity;
+            size_t m_slotSize;
+            size_t m_count = 0;
+
+        public:
+            Batch(size_t capacity, size_t slotSize = s_defaultSlotSize);
+            ~Batch();
+
+            Batch(Batch&&) noexcept;
+            Batch& operator=(Batch&&) noexcept;
+
+            size_t capacity() const { return m_capacity; }
+            size_t slotSize() const { return m_slotSize; }
+            size_t size() const { return m_count; }
+            bool empty() const { return m_count == 0; }
+            void clear() { m_count = 0; }
+
+            std::string_view data(size_t index) const;
+
+            // sender of a received datagram, destination of a pushed one
+            AddressIn address(size_t index) const;
+
+            // gro merged several datagrams of this size into the slot, 0 if it holds a single one
+            size_t segmentSize(size_t index) const;
+
+            // copies the payload into the next free slot, unconnected sockets need a destination,
+            // false once the batch is full or the payload is larger than a slot
+            bool push(std::string_view payload, const AddressIn* to = nullptr);
+        };
+
+        // return false to stop receiving
+        using ReceiveHandler = std::function<bool(Batch&)>;
+
+        DatagramSocket(Domain domain = Domain::IPv4);
+
+        static AddressIn makeAddress(const char* ip, uint16_t port);
+
+        // fills the batch with up to capacity datagrams in one call, 0 if nothing is pending on a non-blocking socket,
+        // a blocking socket only waits for the first datagram
+        size_t receiveBatch(Batch& batch);
+
+        // sends the slots from first on in one call, returns how many left before the socket would block
+        size_t sendBatch(Batch& batch, size_t first = 0);
+
+        // gso, the kernel cuts every send into datagrams of segmentSize (0 turns it off),
+        // false if the kernel doesn't support it
+        bool setSegmentSize(uint16_t segmentSize);
+
+        // gro, consecutive datagrams of a flow arrive merged in one slot, slots should be s_maxSegmentedSize,
+        // false if the kernel doesn't support it
+        bool setReceiveOffload(bool enable = true);
+
+        // readiness backends wait in the reactor and drain a few batches per wakeup, the blocking one
+        // holds a pool thread, socket and batch have to outlive the loop
+        void asyncReceive(IOContext& context, Batch& batch, ReceiveHandler handler);
+    };
+}
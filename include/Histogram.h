@@ -0,0 +1,66 @@
+#pragma once
+#include "Common.h"
+
+#include <bit>
+#include <cmath>
+
+namespace Network {
+
+    // lock free distribution over power of two buckets, several run loops record into it at once,
+    // percentiles are only as exact as the bucket (within a factor of two)
+    class Histogram {
+    public:
+        static constexpr size_t s_bucketCount = 65; // 0, then one per bit width of a 64 bit value
+
+    private:
+        std::array<std::atomic<uint64_t>, s_bucketCount> m_buckets{};
+        std::atomic<uint64_t> m_count = 0;
+        std::atomic<uint64_t> m_sum = 0;
+        std::atomic<uint64_t> m_max = 0;
+
+    public:
+        void record(uint64_t value) {
+            m_buckets[std::bit_width(value)].fetch_add(1, std::memory_order_relaxed);
+            m_count.fetch_add(1, std::memory_order_relaxed);
+            m_sum.fetch_add(value, std::memory_order_relaxed);
+
+            uint64_t max = m_max.load(std::memory_order_relaxed);
+            while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed));
+        }
+
+        uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+
+        uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+
+        double mean() const {
+            auto samples = count();
+            return samples == 0 ? 0.0 : static_cast<double>(m_sum.load(std::memory_order_relaxed)) / samples;
+        }
+
+        // upper bound of the bucket holding the given fraction (0..1) of the samples, capped at the max seen
+        uint64_t percentile(double fraction) const {
+            auto samples = count();
+            if (samples == 0)
+                return 0;
+
+            auto rank = static_cast<uint64_t>(std::ceil(fraction * samples));
+            uint64_t seen = 0;
+            for (size_t i = 0; i < s_bucketCount; i++) {
+                seen += m_buckets[i].load(std::memory_order_relaxed);
+                if (seen >= std::max<uint64_t>(rank, 1)) {
+                    uint64_t upper = i == 0 ? 0 : (i == 64 ? UINT64_MAX : (uint64_t(1) << i) - 1);
+                    return std::min(upper, max());
+                }
+            }
+            return max();
+        }
+
+        void reset() {
+            for (auto& bucket : m_buckets)
+                bucket.store(0, std::memory_order_relaxed);
+            m_count = 0;
+            m_sum = 0;
+            m_max = 0;
+        }
+    };
+}
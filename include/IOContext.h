@@ -1,6 +1,14 @@
 #pragma once
 #include "Common.h"
 #include "Socket.h"
+#include "Reactor.h"
+#include "Uring.h"
+#include "CompletionQueue.h"
+#include "WorkStealingPool.h"
+#include "TimerWheel.h"
+#include "Task.h"
+
+#include <variant>
 
 
 class IOContext
@@ -11,18 +19,73 @@ public:
 		size_t bytesSent = 0;
 		size_t bytesReceived = 0;
 		size_t iterationCount = 0;
+		size_t zeroCopyBytes = 0; // part of bytesSent the kernel sent without copying
+		std::optional<Network::Socket::TcpInfo> tcpInfo; // taken at the end, only if the session samples TCP_INFO
 	};
 
 	using AcceptCallback = std::function<void(Network::Socket&&)>;
 	using ParserCallback = std::function<void(size_t)>; //returns bytes sent
 	using SessionCallback = std::function<void(SessionData)>; //returns total sent bytes and the number of iterations
 
+	// typed completion records, all of them go through one fifo so nothing waits behind another kind's queue
+	struct AcceptCompletion
+	{
+		Network::Socket socket;
+		AcceptCallback callback;
+	};
+
+	// one drain of the listener backlog, handed to the callback one socket at a time
+	struct AcceptBatchCompletion
+	{
+		std::vector<Network::Socket> sockets;
+		AcceptCallback callback;
+	};
+
+	struct ParserCompletion
+	{
+		size_t bytes;
+		ParserCallback callback;
+	};
+
+	struct SessionCompletion
+	{
+		SessionData data;
+		SessionCallback callback;
+	};
+
+	// monostate only wakes run() up, stop() uses it
+	using Completion = std::variant<std::monostate, AcceptCompletion, AcceptBatchCompletion, ParserCompletion, SessionCompletion>;
+
+	// counted by run(), readable from any thread
+	struct Stats
+	{
+		size_t completions = 0;
+		size_t completionBatches = 0;
+		size_t acceptedConnections = 0;
+		size_t finishedSessions = 0;
+	};
+
+	// run() hands this many completions to their callbacks before it looks at the queue again
+	static constexpr size_t s_maxCompletionBatch = 64;
+
+	enum class Backend {
+		Blocking, // every session holds a pool thread for its whole lifetime
+		Epoll, // sessions park in the reactor between requests, pool threads only run ready work
+		IoUring, // like Epoll, plus multishot accept/receive and linked sends, falls back to Epoll if unavailable
+	};
+
 private:
-	MT::ThreadPool m_pool;
+	WorkStealingPool m_pool;
+	TimerWheel m_timers{ m_pool };
+	std::unique_ptr<Reactor> m_reactor;
+	std::unique_ptr<Uring> m_uring;
+	Backend m_backend = Backend::Blocking;
 	std::atomic<bool> m_shouldRun;
-	MT::Deque<std::pair<Network::Socket, AcceptCallback>> m_acceptCallbackQueue;
-	MT::Deque<std::pair<size_t, ParserCallback>> m_parserCallbackQueue;
-	MT::Deque<std::pair<SessionData, SessionCallback>> m_sessionCallbackQueue;
+	CompletionQueue<Completion> m_completions;
+	std::atomic<size_t> m_completionCount = 0;
+	std::atomic<size_t> m_completionBatchCount = 0;
+	std::atomic<size_t> m_acceptedCount = 0;
+	std::atomic<size_t> m_finishedSessionCount = 0;
 
 	size_t m_threadCount;
 
@@ -31,48 +94,263 @@ public:
 	IOContext(size_t threadCount = std::thread::hardware_concurrency() * 4) :
 		m_threadCount(threadCount) {
 		m_pool.init(m_threadCount);
+		m_timers.start();
 	};
 
+	// the reactor only needs a small fixed pool, one thread per core is plenty
+	IOContext(Backend backend, size_t threadCount = 0) :
+		m_backend(backend), m_threadCount(threadCount != 0 ? threadCount : defaultThreadCount(backend)) {
+		m_pool.init(m_threadCount);
+		m_timers.start();
+		if (m_backend == Backend::IoUring) {
+			try {
+				m_uring = std::make_unique<Uring>(m_pool);
+				m_uring->start();
+			}
+			catch (const std::exception& e) {
+				std::cerr << e.what() << ", falling back to epoll" << std::endl;
+				m_backend = Backend::Epoll;
+			}
+		}
+		if (m_backend == Backend::Epoll) {
+			m_reactor = std::make_unique<Reactor>(m_pool);
+			m_reactor->start();
+		}
+	};
+
+	static Backend backendFromString(const std::string& name) {
+		if (name == "epoll")
+			return Backend::Epoll;
+		if (name == "io_uring" || name == "uring")
+			return Backend::IoUring;
+		return Backend::Blocking;
+	}
+
+	static size_t defaultThreadCount(Backend backend) {
+		return backend == Backend::Blocking ?
+			std::thread::hardware_concurrency() * 4 : std::thread::hardware_concurrency();
+	}
+
+	// drains completions in arrival order on the calling thread, one thread per context since the queue has a single consumer
 	void run() {
 		m_shouldRun = true;
-		std::pair<Network::Socket, AcceptCallback> bufferAccept;
-		std::pair<size_t, ParserCallback> bufferParser;
-		std::pair<SessionData, SessionCallback> bufferSession;
+		std::vector<Completion> batch;
+		batch.reserve(s_maxCompletionBatch);
 
 		while (m_shouldRun.load())
 		{
-			if (m_acceptCallbackQueue.waitAndPopBackFor(bufferAccept, std::chrono::milliseconds(50)))
-				bufferAccept.second(std::move(bufferAccept.first));
-			if (m_parserCallbackQueue.waitAndPopBackFor(bufferParser, std::chrono::milliseconds(50)))
-				bufferParser.second(std::move(bufferParser.first));
-			if (m_sessionCallbackQueue.waitAndPopBackFor(bufferSession, std::chrono::milliseconds(50)))
-				bufferSession.second(std::move(bufferSession.first));
+			batch.clear();
+			if (m_completions.drain(batch, s_maxCompletionBatch) == 0) {
+				m_completions.waitForWork();
+				continue;
+			}
+
+			m_completionBatchCount.fetch_add(1, std::memory_order_relaxed);
+			m_completionCount.fetch_add(batch.size(), std::memory_order_relaxed);
+			for (auto& completion : batch)
+				dispatch(completion);
 		}
 	}
 
 	void stop() {
 		m_shouldRun = false;
+		m_completions.push(std::monostate{});
+		m_timers.stop();
+		if (m_uring)
+			m_uring->stop();
+		if (m_reactor)
+			m_reactor->stop();
 		m_pool.shutdown();
 	}
 
+	Backend getBackend() const { return m_backend; }
+
+	size_t getThreadCount() const { return m_threadCount; }
+
+	WorkStealingPool::Stats getPoolStats() const { return m_pool.getStats(); }
+
+	Stats getStats() const {
+		return Stats{ m_completionCount.load(std::memory_order_relaxed), m_completionBatchCount.load(std::memory_order_relaxed),
+			m_acceptedCount.load(std::memory_order_relaxed), m_finishedSessionCount.load(std::memory_order_relaxed) };
+	}
+
+	// true for every readiness driven backend, sockets are then expected to be non-blocking
+	bool hasReactor() const { return m_reactor != nullptr || m_uring != nullptr; }
+
+	bool hasUring() const { return m_uring != nullptr; }
+
+	Reactor& getReactor() {
+		if (!m_reactor)
+			throw std::runtime_error("IOContext was created without a reactor backend");
+		return *m_reactor;
+	}
+
+	Uring& getUring() {
+		if (!m_uring)
+			throw std::runtime_error("IOContext was created without an io_uring backend");
+		return *m_uring;
+	}
+
+	// the callback runs on the pool once the socket is ready or the timeout expires
+	template<typename Duration>
+	void asyncWait(const Network::Socket& socket, Reactor::Event event,
+		const Duration& timeout, Reactor::WaitCallback callback) {
+		if (m_uring)
+			m_uring->asyncWait(socket.getHandle(), event, timeout, std::move(callback));
+		else
+			getReactor().asyncWait(socket.getHandle(), event, timeout, std::move(callback));
+	}
+
+	void asyncWait(const Network::Socket& socket, Reactor::Event event, Reactor::WaitCallback callback) {
+		if (m_uring)
+			m_uring->asyncWait(socket.getHandle(), event, std::move(callback));
+		else
+			getReactor().asyncWait(socket.getHandle(), event, std::move(callback));
+	}
+
+	void cancel(const Network::Socket& socket) {
+		if (m_uring)
+			m_uring->cancel(socket.getHandle());
+		if (m_reactor)
+			m_reactor->cancel(socket.getHandle());
+	}
+
+	// from a pool thread the task runs next on that same thread unless an idle one steals it first
 	void post(std::function<void()> task) {
-		m_pool.pushTask(task);
+		m_pool.pushTask(std::move(task));
+	}
+
+	// the task runs on the pool once the timeout passed unless the timer is cancelled first, O(1) either way
+	TimerWheel::Id setTimer(std::chrono::milliseconds timeout, std::function<void()> task) {
+		return m_timers.arm(timeout, std::move(task));
+	}
+
+	bool cancelTimer(TimerWheel::Id& timer) {
+		return m_timers.cancel(timer);
+	}
+
+	// co_await waitReady(socket, event) parks the coroutine in the reactor and resumes it on the pool,
+	// true once ready, false if the timeout passed first, blocking contexts don't wait at all
+	struct ReadyAwaiter
+	{
+		IOContext& context;
+		const Network::Socket& socket;
+		Reactor::Event event;
+		std::optional<Reactor::Clock::duration> timeout;
+		bool ready = true;
+
+		bool await_ready() const { return !context.hasReactor(); }
+
+		void await_suspend(std::coroutine_handle<> handle) {
+			auto callback = [this, handle](bool isReady) {
+				ready = isReady;
+				handle.resume();
+			};
+			if (timeout)
+				context.asyncWait(socket, event, *timeout, std::move(callback));
+			else
+				context.asyncWait(socket, event, std::move(callback));
+		}
+
+		bool await_resume() const { return ready; }
+	};
+
+	ReadyAwaiter waitReady(const Network::Socket& socket, Reactor::Event event) {
+		return ReadyAwaiter{ *this, socket, event, std::nullopt };
+	}
+
+	template<typename Duration>
+	ReadyAwaiter waitReady(const Network::Socket& socket, Reactor::Event event, const Duration& timeout) {
+		return ReadyAwaiter{ *this, socket, event, std::chrono::duration_cast<Reactor::Clock::duration>(timeout) };
+	}
+
+	// co_await schedule() moves the coroutine onto the pool
+	struct ScheduleAwaiter
+	{
+		IOContext& context;
+
+		bool await_ready() const { return false; }
+		void await_suspend(std::coroutine_handle<> handle) { context.post([handle]() { handle.resume(); }); }
+		void await_resume() const {}
+	};
+
+	ScheduleAwaiter schedule() { return ScheduleAwaiter{ *this }; }
+
+	// co_await sleepFor(timeout) resumes on the pool once the timer wheel fired
+	struct SleepAwaiter
+	{
+		IOContext& context;
+		std::chrono::milliseconds timeout;
+
+		bool await_ready() const { return timeout.count() <= 0; }
+		void await_suspend(std::coroutine_handle<> handle) { context.setTimer(timeout, [handle]() { handle.resume(); }); }
+		void await_resume() const {}
+	};
+
+	SleepAwaiter sleepFor(std::chrono::milliseconds timeout) { return SleepAwaiter{ *this, timeout }; }
+
+	// starts the task on the pool and lets it run on its own, whatever it throws is logged
+	void spawn(Task<void> task) {
+		runDetached(*this, std::move(task));
+	}
+
+	// with a reactor the task only reaches the pool once the socket is ready, otherwise it's posted right away
+	void postWhenReady(const Network::Socket& socket, Reactor::Event event, std::function<void()> task) {
+		if (!hasReactor()) {
+			post(std::move(task));
+			return;
+		}
+		asyncWait(socket, event, [task = std::move(task)](bool) { task(); });
 	}
 
 	void postAcceptCallback (Network::Socket&& socket, AcceptCallback task) {
-		m_acceptCallbackQueue.pushBack(std::make_pair(std::move(socket), task));
+		m_completions.push(AcceptCompletion{ std::move(socket), std::move(task) });
+	}
+
+	void postAcceptCallbacks(std::vector<Network::Socket>&& sockets, AcceptCallback task) {
+		m_completions.push(AcceptBatchCompletion{ std::move(sockets), std::move(task) });
 	}
 
 	void postParserCallback(size_t bytesRead, ParserCallback task) {
-		m_parserCallbackQueue.pushBack(std::make_pair(bytesRead, task));
+		m_completions.push(ParserCompletion{ bytesRead, std::move(task) });
 	}
 
 	void postSessionCallback(SessionData&& data, SessionCallback task) {
-		m_sessionCallbackQueue.pushBack(std::make_pair(std::move(data), task));
+		m_completions.push(SessionCompletion{ std::move(data), std::move(task) });
 	}
 
 	~IOContext() {
 	}
 
+private:
+	static TaskDetail::DetachedTask runDetached(IOContext& context, Task<void> task) {
+		co_await context.schedule();
+		try {
+			co_await task;
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Task error: " << e.what() << std::endl;
+		}
+	}
+
+	void dispatch(Completion& completion) {
+		if (auto accept = std::get_if<AcceptCompletion>(&completion)) {
+			m_acceptedCount.fetch_add(1, std::memory_order_relaxed);
+			accept->callback(std::move(accept->socket));
+		}
+		else if (auto batch = std::get_if<AcceptBatchCompletion>(&completion)) {
+			m_acceptedCount.fetch_add(batch->sockets.size(), std::memory_order_relaxed);
+			for (auto& socket : batch->sockets)
+				batch->callback(std::move(socket));
+		}
+		else if (auto parser = std::get_if<ParserCompletion>(&completion)) {
+			parser->callback(parser->bytes);
+		}
+		else if (auto session = std::get_if<SessionCompletion>(&completion)) {
+			m_finishedSessionCount.fetch_add(1, std::memory_order_relaxed);
+			session->callback(std::move(session->data));
+		}
+	}
+
 };
 
@@ -3,6 +3,8 @@
 #include "Socket.h"
 #include "Body.h"
 
+#include <bit>
+
 namespace Network::HTTP
 {
     class Message {
@@ -82,230 +84,301 @@ namespace Network::HTTP
 				"Access-Control-Allow-Headers"
             };
 
-            static inline const std::unordered_map<std::string, Standard, 
-                Detail::CaseInsensitiveHasher, Detail::CaseInsensitiveStringComparator> s_headerFromString = {
-                {"accept", Standard::Accept},
-                {"accept-charset", Standard::AcceptCharset},
-                {"accept-encoding", Standard::AcceptEncoding},
-                {"accept-language", Standard::AcceptLanguage},
-                {"authorization", Standard::Authorization},
-                {"cache-control", Standard::CacheControl},
-                {"connection", Standard::Connection},
-                {"content-length", Standard::ContentLength},
-                {"content-type", Standard::ContentType},
-                {"cookie", Standard::Cookie},
-                {"date", Standard::Date},
-                {"host", Standard::Host},
-                {"if-match", Standard::IfMatch},
-                {"if-modified-since", Standard::IfModifiedSince},
-                {"if-none-match", Standard::IfNoneMatch},
-                {"if-range", Standard::IfRange},
-                {"if-unmodified-since", Standard::IfUnmodifiedSince},
-                {"location", Standard::Location},
-                {"max-forwards", Standard::MaxForwards},
-                {"pragma", Standard::Pragma},
-                {"proxy-authorization", Standard::ProxyAuthorization},
-                {"range", Standard::Range},
-                {"referer", Standard::Referer},
-                {"server", Standard::Server},
-                {"te", Standard::Te},
-                {"transfer-encoding", Standard::TransferEncoding},
-                {"upgrade", Standard::Upgrade},
-                {"user-agent", Standard::UserAgent},
-                {"via", Standard::Via},
-                {"warning", Standard::Warning},
-                {"Access-Control-Allow-Origin", Standard::AccessControlAllowOrigin},
-				{"Access-Control-Allow-Methods", Standard::AccessControlAllowMethods},
-				{"Access-Control-Allow-Headers", Standard::AccessControlAllowHeaders}
+            // longest standard name, Access-Control-Allow-Methods
+            static constexpr size_t s_maxStandardLength = 28;
+            // custom headers kept inside the object before the rest spills to the heap
+            static constexpr size_t s_inlineCustomCount = 8;
+
+            static_assert(static_cast<size_t>(Standard::Count) <= 64, "presence of standard headers is one 64 bit mask");
+
+        private:
+            // every value lives in m_storage and is kept as an offset into it, so copies and moves need no fixups
+            struct Slice
+            {
+                uint32_t offset = 0;
+                uint32_t length = 0;
+            };
+
+            struct CustomField
+            {
+                Slice name;
+                Slice value;
             };
 
+            // the parsed head copied once, values set later are appended behind it,
+            // replaced and removed values are never reclaimed, the space is only reused after clear()
+            std::string m_storage;
+
+            uint64_t m_present = 0; // bit i set if standard header i is
+            std::array<Slice, static_cast<size_t>(Standard::Count)> m_standard{};
+
+            std::array<CustomField, s_inlineCustomCount> m_inlineCustom{};
+            std::vector<CustomField> m_spilledCustom;
+            size_t m_customCount = 0;
+
+            static char toLowerAscii(char c) {
+                return c >= 'A' && c <= 'Z' ? static_cast<char>(c + ('a' - 'A')) : c;
+            }
+
+            static bool equalsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+                if (lhs.size() != rhs.size())
+                    return false;
+                for (size_t i = 0; i < lhs.size(); i++) {
+                    if (toLowerAscii(lhs[i]) != toLowerAscii(rhs[i]))
+                        return false;
+                }
+                return true;
+            }
+
+            std::string_view view(Slice slice) const {
+                return std::string_view(m_storage.data() + slice.offset, slice.length);
+            }
+
+            // the slice of a value already inside m_storage (the stored head or an earlier value), nullopt otherwise
+            std::optional<Slice> reference(std::string_view value) const {
+                std::less_equal<const char*> notAfter;
+                if (!value.empty() && notAfter(m_storage.data(), value.data())
+                    && notAfter(value.data() + value.size(), m_storage.data() + m_storage.size()))
+                    return Slice{ static_cast<uint32_t>(value.data() - m_storage.data()), static_cast<uint32_t>(value.size()) };
+                return std::nullopt;
+            }
+
+            Slice append(std::string_view value) {
+                Slice slice{ static_cast<uint32_t>(m_storage.size()), static_cast<uint32_t>(value.size()) };
+                m_storage.append(value);
+                return slice;
+            }
+
+            Slice store(std::string_view value) {
+                auto slice = reference(value);
+                return slice ? *slice : append(value);
+            }
+
+            CustomField& custom(size_t index) {
+                return index < s_inlineCustomCount ? m_inlineCustom[index] : m_spilledCustom[index - s_inlineCustomCount];
+            }
+
+            const CustomField& custom(size_t index) const {
+                return index < s_inlineCustomCount ? m_inlineCustom[index] : m_spilledCustom[index - s_inlineCustomCount];
+            }
+
+            size_t findCustom(std::string_view header) const {
+                for (size_t i = 0; i < m_customCount; i++) {
+                    if (equalsIgnoreCase(view(custom(i).name), header))
+                        return i;
+                }
+                return m_customCount;
+            }
+
+        public:
             class iterator {
             private:
-                std::unordered_map<Standard, std::string>::const_iterator standardIt;
-                std::unordered_map<Standard, std::string>::const_iterator standardEnd;
-                std::unordered_map<std::string, std::string,
-                    Detail::CaseInsensitiveHasher, Detail::CaseInsensitiveStringComparator>::const_iterator customIt;
-                std::unordered_map<std::string, std::string,
-                    Detail::CaseInsensitiveHasher, Detail::CaseInsensitiveStringComparator>::const_iterator customEnd;
-                bool isInStandard;
+                const Headers* headers;
+                uint64_t remaining; // standard headers not visited yet, custom ones follow once it is empty
+                size_t customIndex;
 
             public:
-                iterator(
-                    std::unordered_map<Standard, std::string>::const_iterator stdIt,
-                    std::unordered_map<Standard, std::string>::const_iterator stdEnd,
-                    std::unordered_map<std::string, std::string,
-                    Detail::CaseInsensitiveHasher, Detail::CaseInsensitiveStringComparator>::const_iterator custIt,
-                    std::unordered_map<std::string, std::string,
-                    Detail::CaseInsensitiveHasher, Detail::CaseInsensitiveStringComparator>::const_iterator custEnd,
-                    bool inStandard
-                ) : standardIt(stdIt), standardEnd(stdEnd),
-                    customIt(custIt), customEnd(custEnd),
-                    isInStandard(inStandard) {
+                iterator(const Headers* headers, uint64_t remaining, size_t customIndex)
+                    : headers(headers), remaining(remaining), customIndex(customIndex) {
                 }
 
-                // Iterator operators
                 iterator& operator++() {
-                    if (isInStandard) {
-                        ++standardIt;
-                        if (standardIt == standardEnd) {
-                            isInStandard = false;
-                        }
-                    }
-                    else {
-                        ++customIt;
-                    }
+                    if (remaining != 0)
+                        remaining &= remaining - 1;
+                    else
+                        ++customIndex;
                     return *this;
                 }
 
                 bool operator!=(const iterator& other) const {
-                    if (isInStandard != other.isInStandard) return true;
-                    if (isInStandard) {
-                        return standardIt != other.standardIt;
-                    }
-                    return customIt != other.customIt;
+                    return remaining != other.remaining || customIndex != other.customIndex;
                 }
 
-                // Return type for dereferencing
-                std::pair<std::string, std::string> operator*() const {
-                    if (isInStandard) {
-                        return { s_headerToString[static_cast<size_t>(standardIt->first)], standardIt->second };
+                // views into the headers, valid until they change
+                std::pair<std::string_view, std::string_view> operator*() const {
+                    if (remaining != 0) {
+                        size_t index = std::countr_zero(remaining);
+                        return { s_headerToString[index], headers->view(headers->m_standard[index]) };
                     }
-                    return { customIt->first, customIt->second };
+                    auto& field = headers->custom(customIndex);
+                    return { headers->view(field.name), headers->view(field.value) };
                 }
             };
 
-        private:
-
-            std::unordered_map<Standard, std::string> m_standardHeaders;
-            std::unordered_map<std::string, std::string,
-                Detail::CaseInsensitiveHasher, Detail::CaseInsensitiveStringComparator> m_customHeaders;
+            // keeps a copy of a received head, values set from views into it are referenced instead of copied,
+            // reserve enough for the values that have to be copied after it so the copy is the only allocation
+            void storeHead(std::string_view head, size_t reserve = 0) {
+                m_storage.reserve(m_storage.size() + head.size() + reserve);
+                m_storage.append(head);
+            }
 
-        public:
+            // the stored head, views into it stay valid until the next set() or storeHead()
+            std::string_view getStoredHead() const { return m_storage; }
 
             void set(Standard header, std::string_view value) {
-                m_standardHeaders[header] = value;
+                size_t index = static_cast<size_t>(header);
+                m_standard[index] = store(value);
+                m_present |= uint64_t(1) << index;
             }
 
-            void set(const std::string& header, std::string_view value) {
-                auto it = s_headerFromString.find(header);
-                if (it != s_headerFromString.end())
-                    m_standardHeaders[it->second] = value;
-                else m_customHeaders[header] = value;
+            void set(std::string_view header, std::string_view value) {
+                auto standard = stringToStandard(header);
+                if (standard != Standard::Count) {
+                    set(standard, value);
+                    return;
+                }
+
+                // both are resolved before the first append, which may move m_storage under a view into it
+                auto name = reference(header);
+                auto stored = reference(value);
+
+                size_t index = findCustom(header);
+                if (index == m_customCount) {
+                    if (m_customCount >= s_inlineCustomCount)
+                        m_spilledCustom.emplace_back();
+                    m_customCount++;
+                    custom(index).name = name ? *name : append(header);
+                }
+                custom(index).value = stored ? *stored : append(value);
             }
 
             bool has(Standard header) const {
-                return m_standardHeaders.contains(header);
+                return (m_present >> static_cast<size_t>(header)) & 1;
             }
 
-            bool has(const std::string& header) const {
-                auto it = s_headerFromString.find(header);
-                if (it != s_headerFromString.end())
-                    return m_standardHeaders.contains(it->second);
-                else return m_customHeaders.contains(header);
+            bool has(std::string_view header) const {
+                auto standard = stringToStandard(header);
+                if (standard != Standard::Count)
+                    return has(standard);
+                return findCustom(header) != m_customCount;
             }
 
-            std::string get(Standard header) const {
-                auto it = m_standardHeaders.find(header);
-                return it != m_standardHeaders.end() ? it->second : "";
+            // empty if the header isn't set, the view is valid until the headers change
+            std::string_view get(Standard header) const {
+                return has(header) ? view(m_standard[static_cast<size_t>(header)]) : std::string_view();
             }
 
-            std::string get(const std::string& header) const {
-                auto it = s_headerFromString.find(header);
-                if (it != s_headerFromString.end())
-                {
-                    auto itFin = m_standardHeaders.find(it->second);
-                    return itFin != m_standardHeaders.end() ? itFin->second : "";
-                }
-                else
-                {
-                    auto itFin = m_customHeaders.find(header);
-                    return itFin != m_customHeaders.end() ? itFin->second : "";
+            std::string_view get(std::string_view header) const {
+                auto standard = stringToStandard(header);
+                if (standard != Standard::Count)
+                    return get(standard);
+
+                size_t index = findCustom(header);
+                return index != m_customCount ? view(custom(index).value) : std::string_view();
+            }
+
+            //true if the comma separated value lists token, compared case insensitively (Connection: keep-alive, Upgrade)
+            bool hasToken(Standard header, std::string_view token) const {
+                std::string_view list = get(header);
+                while (!list.empty()) {
+                    size_t comma = std::min(list.find(','), list.size());
+                    auto item = list.substr(0, comma);
+                    list.remove_prefix(std::min(comma + 1, list.size()));
+
+                    size_t start = item.find_first_not_of(" \t");
+                    if (start == std::string_view::npos)
+                        continue;
+                    item = item.substr(start, item.find_last_not_of(" \t") - start + 1);
+                    if (equalsIgnoreCase(item, token))
+                        return true;
                 }
+                return false;
             }
 
             void remove(Standard header) {
-                m_standardHeaders.erase(header);
+                m_present &= ~(uint64_t(1) << static_cast<size_t>(header));
             }
 
-            void remove(const std::string& header) {
-                auto it = s_headerFromString.find(header);
-                if (it != s_headerFromString.end())
-                    m_standardHeaders.erase(it->second);
-                else
-                    m_customHeaders.erase(header);
+            void remove(std::string_view header) {
+                auto standard = stringToStandard(header);
+                if (standard != Standard::Count) {
+                    remove(standard);
+                    return;
+                }
+
+                size_t index = findCustom(header);
+                if (index == m_customCount)
+                    return;
+                for (size_t i = index + 1; i < m_customCount; i++)
+                    custom(i - 1) = custom(i);
+                m_customCount--;
+                if (m_customCount >= s_inlineCustomCount)
+                    m_spilledCustom.pop_back();
             }
 
             std::vector<std::string> getHeaderNames() const {
                 std::vector<std::string> names;
-                names.reserve(m_standardHeaders.size() + m_customHeaders.size());
-
-                for (const auto& [header, _] : m_standardHeaders) {
-                    names.push_back(s_headerToString[static_cast<size_t>(header)]);
-                }
-                for (const auto& [name, _] : m_customHeaders) {
-                    names.push_back(name);
-                }
+                names.reserve(size());
+                for (const auto& [name, _] : *this)
+                    names.emplace_back(name);
                 return names;
             }
 
-            // Iteration support
-            auto standardBegin() const { return m_standardHeaders.begin(); }
-            auto standardEnd() const { return m_standardHeaders.end(); }
-            auto customBegin() const { return m_customHeaders.begin(); }
-            auto customEnd() const { return m_customHeaders.end(); }
-
             size_t size() const {
-                return m_standardHeaders.size() + m_customHeaders.size();
+                return std::popcount(m_present) + m_customCount;
             }
 
             bool empty() const {
-                return m_standardHeaders.empty() && m_customHeaders.empty();
+                return m_present == 0 && m_customCount == 0;
             }
 
             void clear() {
-                m_standardHeaders.clear();
-                m_customHeaders.clear();
+                m_storage.clear();
+                m_present = 0;
+                m_customCount = 0;
+                m_spilledCustom.clear();
             }
 
-            // Utility methods
-            std::string toString() const {
-                std::stringstream ss;
-                // Standard headers
-                for (const auto& [header, value] : m_standardHeaders) {
-                    ss << s_headerToString[static_cast<size_t>(header)] << ": " << value << "\r\n";
-                }
-                // Custom headers
-                for (const auto& [name, value] : m_customHeaders) {
-                    ss << name << ": " << value << "\r\n";
+            // appends every header line, sized up front so out grows at most once
+            void serialize(std::string& out) const {
+                size_t length = 0;
+                for (const auto& [name, value] : *this)
+                    length += name.size() + value.size() + 4;
+                out.reserve(out.size() + length);
+
+                for (const auto& [name, value] : *this) {
+                    out.append(name);
+                    out.append(": ");
+                    out.append(value);
+                    out.append("\r\n");
                 }
-                return ss.str();
+            }
+
+            std::string toString() const {
+                std::string out;
+                serialize(out);
+                return out;
             }
 
             iterator begin() const {
-                bool startInStandard = !m_standardHeaders.empty();
-                return iterator(
-                    m_standardHeaders.begin(), m_standardHeaders.end(),
-                    m_customHeaders.begin(), m_customHeaders.end(),
-                    startInStandard
-                );
+                return iterator(this, m_present, 0);
             }
 
             iterator end() const {
-                return iterator(
-                    m_standardHeaders.end(), m_standardHeaders.end(),
-                    m_customHeaders.end(), m_customHeaders.end(),
-                    false
-                );
+                return iterator(this, 0, m_customCount);
             }
 
             static std::string standardToString(Standard header) {
                 return s_headerToString[static_cast<size_t>(header)];
             }
 
-            static Standard stringToStandard(const std::string& header) {
-                auto it = s_headerFromString.find(header);
-                return it != s_headerFromString.end() ? it->second : Standard::Count;
-			}
+            // Standard::Count if header isn't a standard one, only the names of the same length are compared
+            static Standard stringToStandard(std::string_view header) {
+                static const auto s_byLength = [] {
+                    std::array<std::vector<Standard>, s_maxStandardLength + 1> byLength;
+                    for (size_t i = 0; i < s_headerToString.size(); i++)
+                        byLength[s_headerToString[i].size()].push_back(static_cast<Standard>(i));
+                    return byLength;
+                }();
+
+                if (header.size() > s_maxStandardLength)
+                    return Standard::Count;
+                for (auto standard : s_byLength[header.size()]) {
+                    if (equalsIgnoreCase(s_headerToString[static_cast<size_t>(standard)], header))
+                        return standard;
+                }
+                return Standard::Count;
+            }
         };
 
         enum class Type {
@@ -337,7 +410,8 @@ namespace Network::HTTP
 
         std::unique_ptr<Body>& getBody() { return body; };
         const std::unique_ptr<Body>& getBody() const { return body; };
-        void setVersion(const std::string& ver) { version = ver; };
+        void setVersion(std::string_view ver) { version = ver; };
+        const std::string& getVersion() const { return version; };
 
         virtual Type getType() const { return Type::Unknown; };
 
@@ -386,7 +460,7 @@ namespace Network::HTTP
     public:
         Request() = default;
         void setMethod(const Method& m) { method = m; }
-        void setUri(const std::string& u) { uri = u; }
+        void setUri(std::string_view u) { uri = u; }
         const Method& getMethod() const { return method; }
         std::string_view getUri() const { return uri; }
 
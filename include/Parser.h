@@ -0,0 +1,101 @@
+#pragma once
+#include "Message.h"
+
+namespace Network::HTTP
+{
+    // resumable HTTP/1.x head parser working in place on the receive buffer
+    // parse() gets everything received so far and continues at the line the previous call stopped in,
+    // the first line and the headers are kept as offsets into that buffer and handed out as string_views,
+    // so they stay valid when the buffer grows but only as long as its bytes don't move
+    class Parser
+    {
+    public:
+        struct Header
+        {
+            std::string_view name;
+            std::string_view value; // a folded value still holds its line breaks, unfold() joins them
+            bool folded = false;
+        };
+
+    private:
+        struct Slice
+        {
+            uint32_t offset = 0;
+            uint32_t length = 0;
+        };
+
+        struct HeaderSlices
+        {
+            Slice name;
+            Slice value;
+            bool folded = false;
+        };
+
+        enum class State {
+            FirstLine,
+            Headers,
+            Complete
+        };
+
+        State m_state = State::FirstLine;
+        std::string_view m_data;
+        size_t m_lineStart = 0; // start of the first line not parsed yet
+        size_t m_scanned = 0; // the line feed search goes on from here
+        size_t m_colon = std::string_view::npos; // first colon of the line being scanned, if one was seen yet
+
+        bool m_isRequest = true;
+        Request::Method m_method = Request::Method::Unknown;
+        Response::StatusCode m_statusCode = Response::StatusCode::Unknown;
+        Slice m_target; // uri of a request, status message of a response
+        Slice m_version;
+        std::vector<HeaderSlices> m_headers;
+
+        std::string_view view(Slice slice) const { return m_data.substr(slice.offset, slice.length); }
+        Slice sliceOf(std::string_view part) const {
+            return Slice{ static_cast<uint32_t>(part.data() - m_data.data()), static_cast<uint32_t>(part.size()) };
+        }
+
+        void parseFirstLine(std::string_view line);
+        void parseHeaderLine(std::string_view line, size_t colonPos);
+
+    public:
+        // first line feed at or after from, npos if there is none yet; colon is set to the first ':' in between
+        // unless it already holds one, so a scan cut short by the end of data picks up where it stopped
+        // looks at 32 (AVX2) or 16 (SSE2) bytes per step, byte by byte on other targets
+        static size_t scanLine(std::string_view data, size_t from, size_t& colon);
+
+        // true once the empty line ending the head arrived, throws on a malformed head or one over s_maxHeaderSize,
+        // a line that failed stays unparsed so calling again throws the same error
+        bool parse(std::string_view data);
+
+        void reset();
+
+        bool isComplete() const { return m_state == State::Complete; }
+        bool isRequest() const { return m_isRequest; }
+
+        // bytes of the head including the empty line, whatever follows is the body or the next message
+        size_t getHeadSize() const { return m_lineStart; }
+
+        Request::Method getMethod() const { return m_method; }
+        std::string_view getUri() const { return m_isRequest ? view(m_target) : std::string_view(); }
+        std::string_view getVersion() const { return view(m_version); }
+        Response::StatusCode getStatusCode() const { return m_statusCode; }
+        std::string_view getStatusMessage() const { return m_isRequest ? std::string_view() : view(m_target); }
+
+        size_t getHeaderCount() const { return m_headers.size(); }
+
+        Header getHeader(size_t index) const {
+            auto& header = m_headers[index];
+            return Header{ view(header.name), view(header.value), header.folded };
+        }
+
+        // value of the first header with that name, empty if there is none
+        std::string_view findHeader(std::string_view name) const;
+
+        // a folded value with every line break and the whitespace around it turned into one space
+        static std::string unfold(std::string_view value);
+
+        // the Request or Response the rest of the library works with, only valid once the head is complete
+        std::unique_ptr<Message> toMessage() const;
+    };
+}
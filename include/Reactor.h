@@ -0,0 +1,94 @@
+#pragma once
+#include "Common.h"
+#include "WorkStealingPool.h"
+#include "Socket.h"
+
+// readiness notification for non-blocking sockets
+// every wait is one shot: the callback fires once (ready or timed out) and the
+// caller has to wait again if it wants more, so a handle is never dispatched
+// to two pool threads at the same time
+class Reactor
+{
+public:
+    enum class Event : uint32_t {
+        Read = 1,
+        Write = 2,
+    };
+
+    using WaitCallback = std::function<void(bool)>; //true if ready, false if the deadline expired
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int s_maxEventsPerWait = 256;
+
+private:
+    struct Waiter
+    {
+        WaitCallback callback;
+        uint64_t generation = 0;
+    };
+
+    struct Registration
+    {
+        Waiter read;
+        Waiter write;
+        bool added = false; //handle is known to the kernel
+    };
+
+    struct Deadline
+    {
+        Clock::time_point time;
+        Network::Socket::Handle handle;
+        Event event;
+        uint64_t generation;
+
+        bool operator>(const Deadline& other) const { return time > other.time; }
+    };
+
+    WorkStealingPool& m_pool;
+    std::thread m_thread;
+    std::atomic<bool> m_shouldRun = false;
+
+    int m_pollHandle = -1;
+    int m_wakeHandle = -1;
+
+    std::mutex m_mutex;
+    std::vector<Registration> m_registrations; //indexed by handle, handles are small and dense
+    std::priority_queue<Deadline, std::vector<Deadline>, std::greater<Deadline>> m_deadlines;
+
+    void loop();
+    void wake();
+    void rearm(Network::Socket::Handle handle, Registration& registration);
+    void expireDeadlines(std::vector<std::function<void()>>& ready);
+    int nextTimeout();
+
+public:
+    Reactor(WorkStealingPool& pool);
+    ~Reactor();
+
+    Reactor(const Reactor&) = delete;
+    Reactor& operator=(const Reactor&) = delete;
+
+    void start();
+    void stop();
+
+    // the loop thread, sharded contexts pin it next to the pool
+    std::thread& getThread() { return m_thread; }
+
+    // registers interest in a single readiness event, the callback runs on the pool
+    void asyncWait(Network::Socket::Handle handle, Event event, WaitCallback callback);
+
+    template<typename Duration>
+    void asyncWait(Network::Socket::Handle handle, Event event,
+        const Duration& timeout, WaitCallback callback) {
+        asyncWait(handle, event, Clock::now() +
+            std::chrono::duration_cast<Clock::duration>(timeout), std::move(callback));
+    }
+
+    void asyncWait(Network::Socket::Handle handle, Event event,
+        Clock::time_point deadline, WaitCallback callback);
+
+    // drops pending waits without invoking them, must be called before the handle is closed
+    void cancel(Network::Socket::Handle handle);
+
+    bool isRunning() const { return m_shouldRun.load(); }
+};
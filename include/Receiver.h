@@ -2,6 +2,8 @@
 #include "Socket.h"
 #include "IOContext.h"
 #include "Message.h"
+#include "Parser.h"
+#include "ChunkedDecoder.h"
 
 // takes a client socket a buffer and a io context returns an http request
 // doesn't actually store anything or have a state so its static
@@ -16,12 +18,23 @@ namespace Network::HTTP
 
     private:
 
-        static void parseFirstLine(std::stringstream& line, std::unique_ptr<Message>& message);
-        static bool parseHeaders(std::stringstream& headers, std::unique_ptr<Message>& message);
+        //builds the message out of a completed head, the received bytes after it stay in leftovers
+        static void finishHeader(Parser& parser, Buffer& leftovers, size_t receivedTotal,
+            std::unique_ptr<Message>& message);
 
         //stores bytes if used content length
         static std::pair<Message::TransferMethod, int> determineTransferMethod(std::unique_ptr<Message>& message);
 
+        //how much the coroutine reads ask the socket for at once
+        static constexpr size_t s_receiveChunkSize = 4096;
+
+        //appends what the socket has to leftovers, waits through the context if it has nothing yet, 0 once closed
+        static Task<size_t> receiveMore(IOContext& context, Socket& sock, Buffer& leftovers);
+
+        //receives until leftovers holds at least size bytes, throws if the connection closes first
+        static Task<void> receiveAtLeast(IOContext& context, Socket& sock, Buffer& leftovers,
+            size_t size, size_t& received);
+
     public:
 
 
@@ -50,10 +63,17 @@ namespace Network::HTTP
             }
         }
 
+        static size_t readBody(Socket& sock, Buffer& leftovers,
+            std::unique_ptr<Message>& message, BodyTypeHandler handler);
+
         // parse the message completely
         static size_t read(Socket& sock, std::unique_ptr<Message>& message);
         static size_t read(Socket& sock, std::unique_ptr<Message>& message, BodyTypeHandler handler);
 
+        //leftovers belongs to the connection, what arrived past this message stays there for the next read,
+        //returns the bytes taken off the socket, message stays empty if no complete one arrived
+        static size_t read(Socket& sock, Buffer& leftovers, std::unique_ptr<Message>& message, BodyTypeHandler handler);
+
         static void asyncRead(IOContext& context, Socket& sock,
             std::unique_ptr<Message>& message, std::function<void(size_t)> callback);
 
@@ -65,6 +85,23 @@ namespace Network::HTTP
             Buffer& leftovers, std::unique_ptr<Message>& message,
             std::function<void(size_t)> callback);
 
+        //coroutine versions, a socket with nothing to read parks the coroutine instead of a pool thread,
+        //leftovers carries what was read past one message over to the next one, returns the bytes received
+        //message stays empty if the connection closed before a request started
+        static Task<size_t> asyncReadHeader(IOContext& context, Socket& sock,
+            Buffer& leftovers, std::unique_ptr<Message>& message);
+
+        static Task<size_t> asyncReadBody(IOContext& context, Socket& sock,
+            Buffer& leftovers, std::unique_ptr<Message>& message, BodyTypeHandler handler);
+
+        static Task<size_t> asyncRead(IOContext& context, Socket& sock,
+            Buffer& leftovers, std::unique_ptr<Message>& message, BodyTypeHandler handler);
+
+        //io_uring only, the header arrives through a multishot receive and the callback runs on the pool
+        static void uringReadHeader(IOContext& context, Socket& sock,
+            Buffer& leftovers, std::unique_ptr<Message>& message,
+            std::function<void(size_t)> callback);
+
         template<typename BodyType>
         static void asyncReadBody(IOContext& context, Socket& sock,
             Buffer& leftovers, std::unique_ptr<Message>& message, std::function<void(size_t)> callback)
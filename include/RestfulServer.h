@@ -22,52 +22,98 @@ namespace Network::HTTP
     private:
         using Handler = std::function<std::unique_ptr<Response>(Request&,
             std::span<std::string_view>)>;
+        using AsyncHandler = std::function<Task<std::unique_ptr<Response>>(Request&,
+            std::span<std::string_view>)>;
 
         struct Node {
             std::unordered_map<std::string, Node*, Detail::TransparentStringHash, Detail::TransparentStringEqual> children;
 			Node* parameterChild = nullptr;
             std::array<Handler, static_cast<size_t>(Request::Method::Count)> handlers = { nullptr };
+            std::array<AsyncHandler, static_cast<size_t>(Request::Method::Count)> asyncHandlers = { nullptr };
         };
 
 
+		IOContext m_ioContext; // must outlive and be constructed before m_core
         Server m_core;
 		Node* m_root;
-		IOContext m_ioContext;
 		CorsOptions m_corsOptions;
 
     public:
 
 		RestfulServer(int port, std::string_view name,
-            CorsOptions corsOptions = CorsOptions{}) :
+            CorsOptions corsOptions = CorsOptions{},
+            IOContext::Backend backend = IOContext::Backend::Blocking) :
+            m_ioContext(backend),
             m_core(m_ioContext, port, name),
             m_root(new Node()),
             m_corsOptions(corsOptions) {
 
-            m_core.setHandler(Request::Method::Get, [this](Request& req) { return handleGet(req); });
-            m_core.setHandler(Request::Method::Connect, [this](Request& req) { return handleConnect(req); });
-            m_core.setHandler(Request::Method::Delete, [this](Request& req) { return handleDelete(req); });
-            m_core.setHandler(Request::Method::Head, [this](Request& req) { return handleHead(req); });
-            m_core.setHandler(Request::Method::Options, [this](Request& req) { return handleOptions(req); });
-            m_core.setHandler(Request::Method::Patch, [this](Request& req) { return handlePatch(req); });
-            m_core.setHandler(Request::Method::Post, [this](Request& req) { return handlePost(req); });
-            m_core.setHandler(Request::Method::Put, [this](Request& req) { return handlePut(req); });
-            m_core.setHandler(Request::Method::Trace, [this](Request& req) { return handleTrace(req); });
-            m_core.setHandler(Request::Method::Unknown, [this](Request& req) { return handleUnknown(req); });
+            setCoreHandlers();
+        }
+
+        //same server on a unix domain socket path, for clients on the same host
+        RestfulServer(std::string_view socketPath, std::string_view name,
+            CorsOptions corsOptions = CorsOptions{},
+            IOContext::Backend backend = IOContext::Backend::Blocking) :
+            m_ioContext(backend),
+            m_core(m_ioContext, socketPath, name),
+            m_root(new Node()),
+            m_corsOptions(corsOptions) {
+            setCoreHandlers();
         }
         
         void addEndpoint(std::string path,
             Request::Method method,
             Handler&& handler) {
             if (path[0] != '/') path = "/" + path;
-            registerHandle(m_root, path, method, std::move(handler));
+            registerPath(m_root, path)->handlers[static_cast<size_t>(method)] = std::move(handler);
+        }
+
+        //the handler may co_await without holding a pool thread, sessions of a server with any of these run as coroutines,
+        //has to be added before start()
+        void addEndpoint(std::string path,
+            Request::Method method,
+            AsyncHandler&& handler) {
+            if (path[0] != '/') path = "/" + path;
+            registerPath(m_root, path)->asyncHandlers[static_cast<size_t>(method)] = std::move(handler);
+            m_core.setAsyncHandler(method, [this, method](Request& req) { return handleAsync(req, method); });
         }
 
         void start() {
             m_core.startBlocking();
 		}
 
+        void setSocketProfile(const Socket::Profile& profile) {
+            m_core.setSocketProfile(profile);
+        }
+
+        void setTcpInfoSampling(std::optional<std::chrono::milliseconds> interval = Server::s_defaultTcpInfoInterval) {
+            m_core.setTcpInfoSampling(interval);
+        }
+
+        const Server::TcpStatistics& getTcpStatistics() const {
+            return m_core.getTcpStatistics();
+        }
+
+        void setTimeouts(const Session::Timeouts& timeouts) {
+            m_core.setTimeouts(timeouts);
+        }
+
     private:
 
+        void setCoreHandlers() {
+            m_core.setHandler(Request::Method::Get, [this](Request& req) { return handleGet(req); });
+            m_core.setHandler(Request::Method::Connect, [this](Request& req) { return handleConnect(req); });
+            m_core.setHandler(Request::Method::Delete, [this](Request& req) { return handleDelete(req); });
+            m_core.setHandler(Request::Method::Head, [this](Request& req) { return handleHead(req); });
+            m_core.setHandler(Request::Method::Options, [this](Request& req) { return handleOptions(req); });
+            m_core.setHandler(Request::Method::Patch, [this](Request& req) { return handlePatch(req); });
+            m_core.setHandler(Request::Method::Post, [this](Request& req) { return handlePost(req); });
+            m_core.setHandler(Request::Method::Put, [this](Request& req) { return handlePut(req); });
+            m_core.setHandler(Request::Method::Trace, [this](Request& req) { return handleTrace(req); });
+            m_core.setHandler(Request::Method::Unknown, [this](Request& req) { return handleUnknown(req); });
+        }
+
         std::unique_ptr<Response> handleGet(Request& req);
         std::unique_ptr<Response> handleConnect(Request& req);
         std::unique_ptr<Response> handleDelete(Request& req);
@@ -79,6 +125,9 @@ namespace Network::HTTP
         std::unique_ptr<Response> handleTrace(Request& req);
         std::unique_ptr<Response> handleUnknown(Request& req);
 
+        //async endpoints of the method, everything else goes through the regular handlers
+        Task<std::unique_ptr<Response>> handleAsync(Request& req, Request::Method method);
+
         template<typename DefaultHandler>
         inline std::unique_ptr<Response> handleGeneric(Request& req,
             Request::Method method, DefaultHandler&& defaultHandler) {
@@ -110,7 +159,16 @@ namespace Network::HTTP
             Request::Method method,
             Handler& outHandler,
             std::vector<std::string_view>& outParams) {
-            if (path[0] != '/') return false;
+            node = findNode(node, path, outParams);
+            if (node == nullptr) return false;
+            outHandler = node->handlers[static_cast<size_t>(method)];
+            return outHandler != nullptr;
+        }
+
+        Node* findNode(Node* node,
+            std::string_view path,
+            std::vector<std::string_view>& outParams) {
+            if (path[0] != '/') return nullptr;
             while (path != "")
             {
                 auto segment = getPathSegment(path, 1);
@@ -120,7 +178,7 @@ namespace Network::HTTP
 					node = it->second;
                 }
                 else if (node->parameterChild == nullptr) {
-                    return false;
+                    return nullptr;
                 }
                 else
                 {
@@ -129,8 +187,7 @@ namespace Network::HTTP
                     node = node->parameterChild;
                 }
             }
-            outHandler = node->handlers[static_cast<size_t>(method)];
-            return outHandler != nullptr;
+            return node;
 		}
 
         std::string_view getPathSegment(std::string_view path, size_t startPos) {
@@ -142,7 +199,8 @@ namespace Network::HTTP
             return segment;
         }
         
-        void registerHandle(Node* node, std::string_view path, Request::Method method, Handler&& handler) {            
+        //the node of the path, created along with its parents if missing
+        Node* registerPath(Node* node, std::string_view path) {
             while (path != "")
             {
                 auto segment = getPathSegment(path, 1);
@@ -166,7 +224,7 @@ namespace Network::HTTP
                 }
                 path = path.substr(segment.length() + 1);
             }
-            node->handlers[static_cast<size_t>(method)] = std::move(handler);
+            return node;
 		}
 
         void deleteTree() {
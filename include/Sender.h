@@ -7,12 +7,38 @@ namespace Network::HTTP
 {
     class Sender
     {   
+    private:
+        //what a zero copy send reads from, the socket keeps it until the kernel released the pages
+        struct ZeroCopyBuffers
+        {
+            std::string headers;
+            std::unique_ptr<Body> body;
+        };
+
+        //true if the message can go out as headers plus one contiguous payload (empty without a body)
+        static bool gatherPayload(std::unique_ptr<Message>& message, std::string_view& payload);
+
     public:
 
+        static std::string serializeHeaders(std::unique_ptr<Message>& message);
+
         static size_t sendHeaders(Socket& sock, std::unique_ptr<Message>& message);
         static size_t sendBody(Socket& sock, std::unique_ptr<Message>& message);
+        //a body sent with zero copy is moved out of the message, the socket keeps it until the kernel is done with it
         static size_t send(Socket& sock, std::unique_ptr<Message>& message);
 
+        static void asyncSend(IOContext& context, Socket& sock,
+            std::unique_ptr<Message>& message, std::function<void(size_t)> callback);
+
+        //coroutine version, headers and an in memory body go out gathered and the coroutine waits through the context
+        //while the socket buffer is full, streamed bodies are still sent by the calling thread
+        static Task<size_t> asyncSend(IOContext& context, Socket& sock, std::unique_ptr<Message>& message);
+
+        //io_uring only, headers and a string body go out as linked sends in one submission,
+        //other bodies are sent on the pool, the callback runs on the pool
+        static void uringSend(IOContext& context, Socket& sock,
+            std::unique_ptr<Message>& message, std::function<void(size_t)> callback);
+
     };
 
 }
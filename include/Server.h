@@ -1,7 +1,9 @@
 #pragma once
 #include "Acceptor.h"
 #include "IOContext.h"
+#include "ShardedIOContext.h"
 #include "Session.h"
+#include "Histogram.h"
 
 #include "JsonParser/Value.h"
 
@@ -10,7 +12,28 @@ namespace Network::HTTP
     class Server
     {
     public:
+        //distributions of the TCP_INFO samples of all sessions, rtt in microseconds, windows in segments
+        struct TcpStatistics
+        {
+            Histogram rtt;
+            Histogram rttVariance;
+            Histogram retransmits;
+            Histogram congestionWindow;
+            Histogram unacked;
+            Histogram deliveryRate; //bytes per second
+
+            void record(const Socket::TcpInfo& info) {
+                rtt.record(info.rtt.count());
+                rttVariance.record(info.rttVariance.count());
+                retransmits.record(info.retransmits);
+                congestionWindow.record(info.congestionWindow);
+                unacked.record(info.unacked);
+                deliveryRate.record(info.deliveryRate);
+            }
+        };
+
         using RequestHandlerFunction = std::function<std::unique_ptr<Response>(Request&)>;
+        using AsyncRequestHandlerFunction = std::function<Task<std::unique_ptr<Response>>(Request&)>;
 		using ResponseHandlerFunction = std::function<std::unique_ptr<Message>(Response&)>;
 
         static inline const std::map<std::string, std::string> mimeTypes = {
@@ -44,18 +67,35 @@ namespace Network::HTTP
         };
 
     private:
+        //sessions live on the context of the listener that accepted them
+        struct Listener
+        {
+            IOContext& context;
+            std::unique_ptr<Acceptor> acceptor;
+        };
+
         IOContext& m_context;
-        Acceptor m_acceptor;
+        ShardedIOContext* m_shards = nullptr;
+        std::vector<Listener> m_listeners;
         std::string m_name;
 
         std::atomic<uint64_t> m_temporaryFileCounter = 0;
-        uint64_t m_sessionCounter = 0;
+        std::atomic<uint64_t> m_sessionCounter = 0;
+
+        //statistics, listeners may update them from several run loops
+        std::atomic<size_t> m_totalBytesSent = 0;
+        std::atomic<size_t> m_totalBytesReceived = 0;
+        std::atomic<size_t> m_totalRequests = 0;
+        std::atomic<size_t> m_activeSessions = 0;
+        std::atomic<size_t> m_totalZeroCopyBytes = 0;
+        TcpStatistics m_tcpStatistics;
 
-        //statistics
-        size_t m_totalBytesSent = 0;
-        size_t m_totalBytesReceived = 0;
-        size_t m_totalRequests = 0;
-        size_t m_activeSessions = 0;
+        void accept(Listener& listener);
+
+        Socket::Profile m_socketProfile = s_defaultSocketProfile;
+        Session::TimingHandlerFunction m_timingHandler;
+        std::optional<std::chrono::milliseconds> m_tcpInfoInterval;
+        Session::Timeouts m_timeouts;
 
         std::array<RequestHandlerFunction, static_cast<size_t>(Request::Method::Count)> m_handlers = {
             [this](Request& req) { return std::move(handleGet(req)); },
@@ -73,12 +113,51 @@ namespace Network::HTTP
         ResponseHandlerFunction m_responseHandler =
             [this](Response& res) { return std::move(handleResponse(res)); };
 
+        //take precedence over m_handlers, once any is set new sessions run as coroutines
+        std::array<AsyncRequestHandlerFunction, static_cast<size_t>(Request::Method::Count)> m_asyncHandlers;
+        bool m_hasAsyncHandlers = false;
+
     public:
 
+        //long keep-alive sessions report TCP_INFO this often, sampled between requests
+        static constexpr std::chrono::milliseconds s_defaultTcpInfoInterval = std::chrono::seconds(10);
+
+        //responses go out in one gathered write, nagle would only hold back the tail of a streamed body
+        static inline const Socket::Profile s_defaultSocketProfile{ .noDelay = true };
+
         Server(IOContext& context, int port, std::string_view name) :
-            m_context(context), m_acceptor(context, port), m_name(name) {
+            m_context(context), m_name(name) {
+            m_listeners.push_back(Listener{ context, std::make_unique<Acceptor>(context, port) });
+            setSocketProfile(m_socketProfile);
         };
 
+        //listens on a unix domain socket path instead of a port, '@' prefixed names are abstract (linux only)
+        Server(IOContext& context, std::string_view socketPath, std::string_view name) :
+            m_context(context), m_name(name) {
+            m_listeners.push_back(Listener{ context, std::make_unique<Acceptor>(context, socketPath) });
+            setSocketProfile(m_socketProfile);
+        };
+
+        //one SO_REUSEPORT listener per context so accepts don't serialize through a single socket,
+        //steerByCpu hands each connection to the listener matching the cpu that received it
+        Server(const std::vector<std::reference_wrapper<IOContext>>& contexts, int port,
+            std::string_view name, bool steerByCpu = false) :
+            m_context(contexts.at(0)), m_name(name) {
+            for (auto& context : contexts)
+                m_listeners.push_back(Listener{ context, std::make_unique<Acceptor>(context, port, true) });
+            if (steerByCpu)
+                m_listeners.front().acceptor->steerByCpu(static_cast<uint32_t>(m_listeners.size()));
+            setSocketProfile(m_socketProfile);
+        };
+
+        //one listener per shard, connections stay on the core of the shard that accepted them,
+        //steered by receiving cpu when the shards sit on cpus 0..n-1
+        Server(ShardedIOContext& shards, int port, std::string_view name) :
+            Server(shards.contexts(), port, name, shards.matchesCpuIndices()) {
+            m_shards = &shards;
+        };
+
+        //runs every listener context, the first one on the calling thread, sharded contexts on their pinned threads
         void startBlocking();
 
         void accept();
@@ -89,8 +168,7 @@ namespace Network::HTTP
 
             if (msg->getType() == Message::Type::Request)
             {
-                auto& req = static_cast<Request&>(*msg);
-                return m_handlers[static_cast<size_t>(req.getMethod())](req);
+                return handleRequest(static_cast<Request&>(*msg));
             }
             else
             {
@@ -98,6 +176,13 @@ namespace Network::HTTP
             }
         }
 
+        //awaits the async handler of the method if one is set, otherwise same as handleMessage
+        Task<std::unique_ptr<Message>> handleMessageAsync(std::unique_ptr<Message>& msg);
+
+        std::unique_ptr<Response> handleRequest(Request& req) {
+            return m_handlers[static_cast<size_t>(req.getMethod())](req);
+        }
+
         //default handlers
         std::unique_ptr<Response> handleGet(Request& req);
         std::unique_ptr<Response> handleConnect(Request& req);
@@ -133,9 +218,55 @@ namespace Network::HTTP
             m_handlers[static_cast<size_t>(method)] = handler;
         };
 
+        //the handler may co_await, sessions then wait on the reactor instead of holding a pool thread,
+        //only affects connections accepted after the call
+        void setAsyncHandler(Request::Method method, AsyncRequestHandlerFunction handler) {
+            m_asyncHandlers[static_cast<size_t>(method)] = handler;
+            m_hasAsyncHandlers = true;
+        };
+
         void setResponseHandler(ResponseHandlerFunction handler) {
             m_responseHandler = handler;
         };
+
+        //socket options for every listener and the connections accepted after the call
+        void setSocketProfile(const Socket::Profile& profile) {
+            m_socketProfile = profile;
+            for (auto& listener : m_listeners)
+                listener.acceptor->setProfile(profile);
+        };
+
+        const Socket::Profile& getSocketProfile() const {
+            return m_socketProfile;
+        };
+
+        //turns on kernel timestamping for new connections and reports the timing of each of their requests,
+        //runs on pool threads
+        void setTimingHandler(Session::TimingHandlerFunction handler) {
+            m_timingHandler = std::move(handler);
+            auto profile = m_socketProfile;
+            profile.timestamping = m_timingHandler != nullptr;
+            setSocketProfile(profile);
+        };
+
+        //samples TCP_INFO of connections accepted after the call at their end and every interval in between,
+        //nullopt turns it off (linux only)
+        void setTcpInfoSampling(std::optional<std::chrono::milliseconds> interval = s_defaultTcpInfoInterval) {
+            m_tcpInfoInterval = interval;
+        };
+
+        const TcpStatistics& getTcpStatistics() const {
+            return m_tcpStatistics;
+        };
+
+        //idle, header, body and write deadlines of connections accepted after the call
+        void setTimeouts(const Session::Timeouts& timeouts) {
+            m_timeouts = timeouts;
+        };
+
+        const Session::Timeouts& getTimeouts() const {
+            return m_timeouts;
+        };
     };
 }
 
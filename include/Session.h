@@ -12,61 +12,400 @@ namespace Network::HTTP
     public:
         using BodyHandlerFunction = std::function<std::unique_ptr<Body>(std::unique_ptr<Message>&)>;
         using ResponseHandlerFunction = std::function<std::unique_ptr<Message>(std::unique_ptr<Message>&)>;
+        //a handler that may await, e.g. a downstream service, without holding a pool thread while it waits
+        using AsyncResponseHandlerFunction = std::function<Task<std::unique_ptr<Message>>(std::unique_ptr<Message>&)>;
+
+        //where one request spent its time, needs a timestamping socket,
+        //received -> parsed is queueing and parsing, parsed -> responded the handler, responded -> transmitted sending
+        struct RequestTiming {
+            Socket::Timestamp received{};     //kernel arrival of the first request bytes
+            Socket::Timestamp parsed{};       //request fully read, handler starts
+            Socket::Timestamp responded{};    //handler returned, the response starts going out
+            Socket::Timestamp transmitted{};  //last response byte left the host
+            Socket::Timestamp acknowledged{}; //peer acked the last response byte, unset if the session ended first
+        };
+        using TimingHandlerFunction = std::function<void(const RequestTiming&)>;
+        //deadlines of the phases of one connection, zero turns one off, a passed deadline shuts the socket down
+        struct Timeouts {
+            std::chrono::milliseconds keepAlive = std::chrono::seconds(15); //idle between requests
+            std::chrono::milliseconds header = std::chrono::seconds(10);    //request arriving until its headers are complete
+            std::chrono::milliseconds body = std::chrono::seconds(30);      //headers complete until the body is read
+            std::chrono::milliseconds write = std::chrono::seconds(30);     //whole response
+        };
+
+        using TcpInfoHandlerFunction = std::function<void(const Socket::TcpInfo&)>;
 
     private:
         Socket m_socket;
         ResponseHandlerFunction m_responseHandler;
+        AsyncResponseHandlerFunction m_asyncResponseHandler; //set ones make the session a coroutine
         BodyHandlerFunction m_bodyHandler;
         std::string m_identifier;
 
         size_t m_bytesSent = 0;
         size_t m_bytesReceived = 0;
         size_t m_iterationCount = 0;
+
+        // bytes read past the current request, a pipelined next one starts parsing from here
+        Receiver::Buffer m_leftovers;
+        // io_uring path keeps the in-flight exchange here, the kernel works on it between callbacks
+        std::unique_ptr<Message> m_request;
+        std::unique_ptr<Message> m_response;
+
+        // the last response's tx stamps arrive after it was sent, they're picked up on the next wakeup
+        TimingHandlerFunction m_timingHandler;
+        std::optional<RequestTiming> m_pendingTiming;
+        uint32_t m_pendingLastByte = 0;
+
+        // periodic TCP_INFO samples between requests, the last one goes out with the session data
+        TcpInfoHandlerFunction m_tcpInfoHandler;
+        std::chrono::milliseconds m_tcpInfoInterval{ 0 };
+        std::chrono::steady_clock::time_point m_lastTcpInfo = std::chrono::steady_clock::now();
+
+        // the context's timer wheel enforces the deadline of the current phase
+        IOContext* m_context = nullptr;
+        Timeouts m_timeouts;
+        TimerWheel::Id m_deadline;
+
+        // an ending session checks this often for the completions of its last zero copy response, doubling up to the max
+        static constexpr std::chrono::milliseconds s_zeroCopyPollInterval{ 10 };
+        static constexpr std::chrono::milliseconds s_zeroCopyMaxPollInterval{ 1000 };
     public:
         Session(Socket&& socket, BodyHandlerFunction&& bodyHandler,
             ResponseHandlerFunction&& responseHandler, const std::string& identifier = "") :
             m_socket(std::move(socket)), m_bodyHandler(std::move(bodyHandler)),
             m_responseHandler(std::move(responseHandler)), m_identifier(identifier) {};
 
+        Session(Socket&& socket, BodyHandlerFunction&& bodyHandler,
+            AsyncResponseHandlerFunction&& responseHandler, const std::string& identifier = "") :
+            m_socket(std::move(socket)), m_asyncResponseHandler(std::move(responseHandler)),
+            m_bodyHandler(std::move(bodyHandler)), m_identifier(identifier) {};
+
         ~Session() { m_socket.close(); };
 
         void start() {
-            if (!m_socket.waitForData(std::chrono::seconds(15)))
+            if (!waitForRequest())
                 return;
 
-            while (true) {
-                auto message = receiveMessage();
-                if (message == nullptr)
-                    break;
+            //a pipelined request already buffered is served without waiting on the socket,
+            //requests are answered one after the other so responses go out in order
+            while (serveRequest() && (!m_leftovers.empty() || waitForRequest()));
+
+            m_socket.awaitZeroCopy(Socket::Deadline{});
+        }
+
+        //reads one request and answers it, returns true if the connection should be kept alive
+        bool serveRequest() {
+            collectTiming(false);
+            setDeadline(m_timeouts.header);
+
+            auto message = receiveMessage();
+            if (message == nullptr)
+                return false;
 
-                auto response = m_responseHandler(message);
-                
-                sendResponse(response);
+            //bytes queued before timestamping was turned on carry no stamp
+            RequestTiming timing{ m_socket.takeReceiveTimestamp(), std::chrono::system_clock::now() };
+            if (timing.received == Socket::Timestamp{})
+                timing.received = timing.parsed;
 
-                m_iterationCount++;
+            auto response = m_responseHandler(message);
+            timing.responded = std::chrono::system_clock::now();
 
-                if (!Detail::CaseInsensitiveStringComparator()(
-                    message->getHeaders().get(Message::Headers::Standard::Connection),
-                    "keep-alive")
-                    || !m_socket.waitForData(std::chrono::seconds(15)))
+            setDeadline(m_timeouts.write);
+            sendResponse(response);
+            setDeadline(std::chrono::milliseconds(0));
+
+            finishRequest(timing);
+            return isKeepAlive(message);
+        }
+
+        //serveRequest as a coroutine, waiting for the socket or the handler parks it instead of a pool thread,
+        //bytes read past the request stay in m_leftovers for the next one
+        Task<bool> serveRequestAsync(IOContext& ioContext) {
+            collectTiming(false);
+            setDeadline(m_timeouts.keepAlive);
+
+            if (m_leftovers.empty() && !ioContext.hasReactor() && !waitForRequest())
+                co_return false;
+
+            // tx stamps and zero copy completions landing on the error queue wake the reactor as well, waitForData drains them
+            while (m_leftovers.empty() && ioContext.hasReactor()) {
+                if (!co_await ioContext.waitReady(m_socket, Reactor::Event::Read))
+                    co_return false;
+                if (!m_socket.usesErrorQueue() || m_socket.waitForData(std::chrono::seconds(0)))
                     break;
+                collectTiming(false);
             }
+
+            setDeadline(m_timeouts.header);
+            std::unique_ptr<Message> message;
+            m_bytesReceived += co_await Receiver::asyncReadHeader(ioContext, m_socket, m_leftovers, message);
+            if (message == nullptr)
+                co_return false;
+
+            setDeadline(m_timeouts.body);
+            m_bytesReceived += co_await Receiver::asyncReadBody(ioContext, m_socket, m_leftovers, message, m_bodyHandler);
+
+            RequestTiming timing{ m_socket.takeReceiveTimestamp(), std::chrono::system_clock::now() };
+            if (timing.received == Socket::Timestamp{})
+                timing.received = timing.parsed;
+
+            auto response = co_await m_asyncResponseHandler(message);
+            timing.responded = std::chrono::system_clock::now();
+
+            setDeadline(m_timeouts.write);
+            m_bytesSent += co_await Sender::asyncSend(ioContext, m_socket, response);
+            setDeadline(std::chrono::milliseconds(0));
+
+            finishRequest(timing);
+            co_return isKeepAlive(message);
+        }
+
+        //counts the answered request and queues its timing until the tx stamps of the response are in
+        void finishRequest(const RequestTiming& timing) {
+            m_iterationCount++;
+            sampleTcpInfo();
+
+            if (m_timingHandler && m_socket.isTimestamping()) {
+                collectTiming(true);
+                m_pendingTiming = timing;
+                m_pendingLastByte = static_cast<uint32_t>(m_bytesSent - 1);
+                collectTiming(false);
+            }
+        }
+
+        //gets every request's timing once its tx stamps are in, the socket has to be timestamping
+        void setTimingHandler(TimingHandlerFunction handler) {
+            m_timingHandler = std::move(handler);
+        }
+
+        //hands the pending timing to the handler once both tx stamps arrived, or right away if final
+        void collectTiming(bool final) {
+            if (!m_pendingTiming)
+                return;
+
+            if (m_socket.collectTransmitTimestamps(m_pendingLastByte,
+                m_pendingTiming->transmitted, m_pendingTiming->acknowledged) || final) {
+                m_timingHandler(*m_pendingTiming);
+                m_pendingTiming.reset();
+            }
+        }
+
+        //samples TCP_INFO after a request once interval passed since the last sample, and at the end
+        void setTcpInfoSampling(std::chrono::milliseconds interval, TcpInfoHandlerFunction handler) {
+            m_tcpInfoInterval = interval;
+            m_tcpInfoHandler = std::move(handler);
+        }
+
+        void sampleTcpInfo() {
+            if (!m_tcpInfoHandler)
+                return;
+
+            auto now = std::chrono::steady_clock::now();
+            if (now - m_lastTcpInfo < m_tcpInfoInterval)
+                return;
+            m_lastTcpInfo = now;
+
+            if (auto info = m_socket.getTcpInfo())
+                m_tcpInfoHandler(*info);
+        }
+
+        void setTimeouts(const Timeouts& timeouts) {
+            m_timeouts = timeouts;
+        }
+
+        //replaces the deadline of the current phase, zero only cancels it
+        void setDeadline(std::chrono::milliseconds timeout) {
+            if (m_context == nullptr)
+                return;
+
+            m_context->cancelTimer(m_deadline);
+            if (timeout.count() <= 0)
+                return;
+
+            //the shutdown wakes whatever waits on the socket, which then sees the end of the stream and ends the session
+            m_deadline = m_context->setTimer(timeout, [weak = weak_from_this()]() {
+                if (auto self = weak.lock())
+                    self->m_socket.shutdown();
+                });
+        }
+
+        //blocking wait for the next request, a zero keep alive waits for as long as the peer keeps the connection
+        bool waitForRequest() {
+            if (m_timeouts.keepAlive.count() <= 0)
+                return m_socket.waitForData();
+            return m_socket.waitForData(m_timeouts.keepAlive);
+        }
+
+        //HTTP/1.1 connections persist unless the client sends close, HTTP/1.0 ones only if it asks for keep-alive
+        static bool isKeepAlive(std::unique_ptr<Message>& message) {
+            auto& headers = message->getHeaders();
+            if (message->getVersion() == "HTTP/1.0")
+                return headers.hasToken(Message::Headers::Standard::Connection, "keep-alive");
+            return !headers.hasToken(Message::Headers::Standard::Connection, "close");
         }
 
         void startAssync(IOContext& ioContext, IOContext::SessionCallback&& callback) {
+            m_context = &ioContext;
+            if (m_asyncResponseHandler) {
+                ioContext.spawn(serve(shared_from_this(), ioContext, std::move(callback)));
+                return;
+            }
+
+            if (ioContext.hasReactor()) {
+                awaitRequest(ioContext, std::move(callback));
+                return;
+            }
+
             auto self = shared_from_this();
             ioContext.post([self, &ioContext, callback = std::move(callback)]() {
                 self->start();
-                ioContext.postSessionCallback(IOContext::SessionData{
-                    self->m_bytesSent,self->m_bytesReceived,self->m_iterationCount }, std::move(callback));
+                self->setDeadline(std::chrono::milliseconds(0));
+                self->collectTiming(true);
+                ioContext.postSessionCallback(self->getSessionData(), std::move(callback));
                 });
         }
 
+        //the coroutine session, the frame keeps the session alive until the connection ends
+        static Task<void> serve(std::shared_ptr<Session> self, IOContext& ioContext, IOContext::SessionCallback callback) {
+            try {
+                while (co_await self->serveRequestAsync(ioContext));
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Session error: " << e.what() << std::endl;
+            }
+            self->end(ioContext, std::move(callback));
+        }
+
+        //parks the idle connection in the reactor, a pool thread is only taken once a request arrives
+        void awaitRequest(IOContext& ioContext, IOContext::SessionCallback callback) {
+            auto self = shared_from_this();
+            setDeadline(m_timeouts.keepAlive);
+
+            //a pipelined request is already buffered, the socket may have nothing more to wake the reactor with
+            if (!m_leftovers.empty()) {
+                ioContext.post([self, &ioContext, callback = std::move(callback)]() mutable {
+                    self->onRequestReady(ioContext, std::move(callback), true);
+                    });
+                return;
+            }
+
+            ioContext.asyncWait(m_socket, Reactor::Event::Read,
+                [self, &ioContext, callback = std::move(callback)](bool ready) mutable {
+                    self->onRequestReady(ioContext, std::move(callback), ready);
+                });
+        }
+
+        void onRequestReady(IOContext& ioContext, IOContext::SessionCallback callback, bool ready) {
+            // tx stamps and zero copy completions landing on the error queue wake the reactor as well, waitForData drains them
+            if (ready && m_leftovers.empty() && m_socket.usesErrorQueue() && !m_socket.waitForData(std::chrono::seconds(0))) {
+                collectTiming(false);
+                awaitRequest(ioContext, std::move(callback));
+                return;
+            }
+
+            // the multishot receive can't see rx stamps, timestamping sessions read through the socket
+            if (ready && ioContext.hasUring() && !m_socket.isTimestamping()) {
+                serveRequestUring(ioContext, std::move(callback));
+                return;
+            }
+
+            bool keepAlive = false;
+            try {
+                keepAlive = ready && serveRequest();
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Session error: " << e.what() << std::endl;
+            }
+
+            if (keepAlive) {
+                awaitRequest(ioContext, std::move(callback));
+                return;
+            }
+
+            end(ioContext, std::move(callback));
+        }
+
+        //header through a multishot receive, response through linked sends
+        void serveRequestUring(IOContext& ioContext, IOContext::SessionCallback callback) {
+            auto self = shared_from_this();
+            setDeadline(m_timeouts.header);
+            Receiver::uringReadHeader(ioContext, m_socket, m_leftovers, m_request,
+                [self, &ioContext, callback = std::move(callback)](size_t headerBytes) mutable {
+                    bool keepAlive = false;
+                    try {
+                        //error or eof exit, the read or the parse failed or the peer closed
+                        if (self->m_request == nullptr) {
+                            self->end(ioContext, std::move(callback));
+                            return;
+                        }
+
+                        self->setDeadline(self->m_timeouts.body);
+                        self->m_bytesReceived += headerBytes + Receiver::readBody(self->m_socket,
+                            self->m_leftovers, self->m_request, self->m_bodyHandler);
+                        self->m_response = self->m_responseHandler(self->m_request);
+                        keepAlive = isKeepAlive(self->m_request);
+                    }
+                    catch (const std::exception& e) {
+                        std::cerr << "Session error: " << e.what() << std::endl;
+                        self->end(ioContext, std::move(callback));
+                        return;
+                    }
+
+                    self->setDeadline(self->m_timeouts.write);
+                    Sender::uringSend(ioContext, self->m_socket, self->m_response,
+                        [self, &ioContext, keepAlive, callback = std::move(callback)](size_t bytesSent) mutable {
+                            self->setDeadline(std::chrono::milliseconds(0));
+                            self->m_bytesSent += bytesSent;
+                            self->m_iterationCount++;
+                            self->sampleTcpInfo();
+                            self->m_request.reset();
+                            self->m_response.reset();
+
+                            if (keepAlive && bytesSent > 0)
+                                self->awaitRequest(ioContext, std::move(callback));
+                            else
+                                self->end(ioContext, std::move(callback));
+                        });
+                });
+        }
+
+        IOContext::SessionData getSessionData() const {
+            return IOContext::SessionData{ m_bytesSent, m_bytesReceived, m_iterationCount,
+                m_socket.getZeroCopyStats().zeroCopyBytes,
+                m_tcpInfoHandler ? m_socket.getTcpInfo() : std::nullopt };
+        }
+
+        void end(IOContext& ioContext, IOContext::SessionCallback callback) {
+            setDeadline(std::chrono::milliseconds(0));
+            collectTiming(true);
+            ioContext.cancel(m_socket);
+            releaseZeroCopy(ioContext, std::move(callback), s_zeroCopyPollInterval);
+        }
+
+        //the socket may only be closed once the kernel released the last zero copy response, a closing connection
+        //is usually readable so the reactor can't wait for the completions, they're polled on the timer wheel
+        //with a growing interval instead, a peer that stops acking gets dropped by the kernel which releases them too
+        void releaseZeroCopy(IOContext& ioContext, IOContext::SessionCallback callback, std::chrono::milliseconds interval) {
+            if (!ioContext.hasReactor())
+                m_socket.awaitZeroCopy(Socket::Deadline{});
+
+            if (!m_socket.collectZeroCopy()) {
+                ioContext.setTimer(interval, [self = shared_from_this(), &ioContext, callback = std::move(callback), interval]() mutable {
+                    self->releaseZeroCopy(ioContext, std::move(callback), std::min(interval * 2, s_zeroCopyMaxPollInterval));
+                    });
+                return;
+            }
+
+            ioContext.postSessionCallback(getSessionData(), std::move(callback));
+        }
+
         std::unique_ptr<Message> receiveMessage() {
             std::unique_ptr<Message> msg;
-            std::string leftovers;
-            m_bytesReceived += Receiver::read(m_socket, msg,
+            m_bytesReceived += Receiver::read(m_socket, m_leftovers, msg,
                 [this](std::unique_ptr<Message>& message) ->std::unique_ptr<Body> {
+                    //called once the headers are in, the body gets a deadline of its own
+                    setDeadline(m_timeouts.body);
                     return std::move(m_bodyHandler(message));
                 });
 
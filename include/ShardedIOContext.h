@@ -0,0 +1,61 @@
+#pragma once
+#include "Common.h"
+#include "IOContext.h"
+
+// one IOContext per core, the run loop, the reactor thread and the pool of every shard are pinned to its core,
+// a connection accepted by a shard's listener is then read, handled and answered on that core for its whole life
+class ShardedIOContext
+{
+public:
+	struct ShardStats
+	{
+		size_t core;
+		IOContext::Stats stats;
+	};
+
+private:
+	std::vector<size_t> m_cores;
+	std::vector<std::unique_ptr<IOContext>> m_shards;
+	std::vector<std::jthread> m_threads;
+	std::atomic<bool> m_stopped = false;
+
+	static std::vector<size_t> availableCores();
+	static void pinThread(std::thread& thread, size_t core);
+	static void pinCurrentThread(size_t core);
+
+	// the backend thread directly, pool workers by a task each that pins the thread it lands on
+	void pinShard(size_t index);
+
+public:
+	// cores lists the cpu of every shard, empty takes every core the process may run on,
+	// threadsPerShard 0 picks one pool thread for readiness backends (sessions never block it)
+	// and a few for the blocking one
+	ShardedIOContext(IOContext::Backend backend, std::vector<size_t> cores = {}, size_t threadsPerShard = 0);
+
+	// the first shardCount cores the process may run on
+	ShardedIOContext(IOContext::Backend backend, size_t shardCount, size_t threadsPerShard = 0);
+
+	~ShardedIOContext();
+
+	ShardedIOContext(const ShardedIOContext&) = delete;
+	ShardedIOContext& operator=(const ShardedIOContext&) = delete;
+
+	size_t size() const { return m_shards.size(); }
+
+	IOContext& operator[](size_t index) { return *m_shards.at(index); }
+
+	const std::vector<size_t>& getCores() const { return m_cores; }
+
+	// for Server's sharded constructor, one listener per shard in shard order
+	std::vector<std::reference_wrapper<IOContext>> contexts();
+
+	// shard i runs on cpu i, so steering a connection by the cpu that received it keeps it on that core
+	bool matchesCpuIndices() const;
+
+	// runs every shard's loop on its own pinned thread, returns once stop() was called
+	void run();
+
+	void stop();
+
+	std::vector<ShardStats> getStats() const;
+};
@@ -1,5 +1,11 @@
 #pragma once
 #include "Common.h"
+#include "Task.h"
+
+#include <span>
+#include <optional>
+
+class IOContext;
 
 namespace Network {
 
@@ -158,6 +164,67 @@ namespace Network {
 
         static constexpr int s_defaultBacklog = 4096;
 
+        // options an acceptor puts on its listener and every client it hands out, unset fields keep the kernel default,
+        // tcp level options are skipped on unix domain sockets, the ones tcp clients inherit are only set on the listener
+        struct Profile {
+            std::optional<bool> noDelay{};                          // TCP_NODELAY, no 40ms nagle stall on small writes
+            std::optional<bool> quickAck{};                         // TCP_QUICKACK, the kernel clears it again after a while
+            std::optional<int> sendBufferSize{};                    // SO_SNDBUF
+            std::optional<int> receiveBufferSize{};                 // SO_RCVBUF
+            std::optional<std::chrono::microseconds> busyPoll{};    // SO_BUSY_POLL
+            std::optional<std::chrono::milliseconds> userTimeout{}; // TCP_USER_TIMEOUT, drops peers that stop acking
+            std::optional<size_t> zeroCopyThreshold{};              // SO_ZEROCOPY, see setZeroCopy
+            std::optional<bool> timestamping{};                     // SO_TIMESTAMPING, see setTimestamping
+
+            // listener only
+            std::optional<std::chrono::seconds> deferAccept{};      // TCP_DEFER_ACCEPT, wake up once the request arrives
+            std::optional<int> fastOpenQueue{};                     // TCP_FASTOPEN, pending syn+data connections
+        };
+
+        using Timestamp = std::chrono::system_clock::time_point; // kernel software stamps use CLOCK_REALTIME
+
+        struct ZeroCopyStats {
+            size_t zeroCopyBytes = 0;   // sent straight from our pages
+            size_t copiedBytes = 0;     // sent while zero copy was on, below the threshold or copied by the kernel anyway
+        };
+
+        // one TCP_INFO sample of the connection's path as the kernel sees it
+        struct TcpInfo {
+            std::chrono::microseconds rtt{ 0 };          // smoothed round trip time
+            std::chrono::microseconds rttVariance{ 0 };
+            uint32_t retransmits = 0;                   // segments retransmitted over the connection's lifetime
+            uint32_t congestionWindow = 0;              // in segments
+            uint32_t unacked = 0;                       // segments in flight
+            uint64_t deliveryRate = 0;                  // bytes per second, 0 on kernels before 4.9
+        };
+
+        // below this the page pinning and completion round trip cost more than the copy
+        static constexpr size_t s_defaultZeroCopyThreshold = 64 * 1024;
+
+        // bounds how long a loop may block on readiness when the socket would block,
+        // `at` caps the whole operation and a non zero `stall` pushes it out again after every bit of progress
+        struct Deadline {
+            using Clock = std::chrono::steady_clock;
+
+            Clock::time_point at = Clock::time_point::max();
+            std::chrono::milliseconds stall{ 0 };
+
+            static Deadline after(std::chrono::nanoseconds timeout) {
+                return Deadline{ Clock::now() + timeout };
+            }
+
+            static Deadline stalledFor(std::chrono::milliseconds window) {
+                return Deadline{ Clock::now() + window, window };
+            }
+
+            void progress() {
+                if (stall.count() > 0)
+                    at = Clock::now() + stall;
+            }
+
+            bool expired() const { return Clock::now() >= at; }
+        };
+
     private:
         int m_timeout = 0;  // in seconds
         bool m_nonBlocking = false;
@@ -170,12 +237,65 @@ namespace Network {
 
         bool m_isConnected = false;
 
+        size_t m_zeroCopyThreshold = 0;  // 0 = off
+        uint32_t m_zeroCopyNextId = 0;   // the kernel numbers every MSG_ZEROCOPY send, completions come back as id ranges
+        ZeroCopyStats m_zeroCopyStats;
+        uint32_t m_zeroCopyFirstId = 0;
+        std::deque<size_t> m_zeroCopyInFlight; // bytes of each send from m_zeroCopyFirstId on, 0 once released
+        size_t m_zeroCopyOutstanding = 0;
+        // owners of the buffers zero copy sends read from, each with the id of its last send, kept until that one is released
+        std::deque<std::pair<uint32_t, std::shared_ptr<void>>> m_zeroCopyHeld;
+
+        // tx stamps are keyed by the offset of the last byte of a send, counted from when stamping was enabled
+        struct TransmitStamp {
+            uint32_t key = 0;
+            Timestamp time{};
+        };
+
+        bool m_timestamping = false;
+        Timestamp m_receiveTimestamp{};
+        TransmitStamp m_transmitted;
+        TransmitStamp m_acknowledged;
+
+        // drops released sends off the front of m_zeroCopyInFlight and the owners no send in flight reads from
+        void releaseZeroCopy();
+
+        // zero copy completions and tx timestamps share the error queue, this reads both without blocking
+        size_t drainErrorQueue();
+
+        int receiveStamped(char* buffer, size_t len);
+
+        // stall window the retry count overloads use, the old 10..160ms backoff ladder added up
+        // or the socket timeout if one is set, whichever is longer
+        Deadline retryDeadline(size_t maxRetryCount) const;
+
+        // polls until the socket is readable/writable, false once the deadline passes
+        bool waitReady(bool forWrite, const Deadline& deadline);
+
+        // same for any poll events, 0 still wakes up on errors and hangups
+        bool waitEvents(short events, const Deadline& deadline);
+
+        // the error path of the send/receive loops kept out of line, true if the call should be retried
+        // (interrupted, or ready again before the deadline), otherwise logs why the loop stops
+        bool retryAfterError(bool forWrite, const Deadline& deadline);
+
+        // one gathered write of everything past offset without waiting, asyncSend calls it again once writable
+        int sendGathered(const std::vector<std::string_view>& buffers, size_t offset);
+
+        // parks asyncRead/asyncSend until the socket is ready again, the error queue is drained first,
+        // otherwise a queued tx stamp or zero copy completion keeps raising POLLERR and the wait returns right away
+        Task<void> asyncWaitReady(IOContext& context, bool forWrite);
+
+        // the gathered sendCommited loop, zeroCopy sends with MSG_ZEROCOPY while the kernel has optmem for it
+        int sendAll(const std::vector<std::string_view>& buffers, Deadline deadline, bool more, bool zeroCopy);
+
     protected:
         // Constructor for accepted sockets
         Socket(Handle fd, AddressIn adr,
             int timeout = 30, bool nonBlocking = false) :
-            m_sockfd(fd), m_addr(adr), m_isConnected(true),
-            m_timeout(0), m_nonBlocking(false) {
+            m_timeout(0), m_nonBlocking(false), m_sockfd(fd),
+            m_domain(static_cast<Domain>(adr.sin_family)), m_type(Type::Stream), m_protocol(Protocol::Default),
+            m_addr(adr), m_isConnected(true) {
         };
 
     public:
@@ -196,6 +316,19 @@ namespace Network {
             m_protocol = std::exchange(other.m_protocol, Protocol::Unknown);
             m_addr = std::exchange(other.m_addr, {});
             m_isConnected = std::exchange(other.m_isConnected, false);
+            m_timeout = std::exchange(other.m_timeout, 0);
+            m_nonBlocking = std::exchange(other.m_nonBlocking, false);
+            m_zeroCopyThreshold = std::exchange(other.m_zeroCopyThreshold, 0);
+            m_zeroCopyNextId = std::exchange(other.m_zeroCopyNextId, 0);
+            m_zeroCopyStats = std::exchange(other.m_zeroCopyStats, {});
+            m_zeroCopyFirstId = std::exchange(other.m_zeroCopyFirstId, 0);
+            m_zeroCopyInFlight = std::move(other.m_zeroCopyInFlight);
+            m_zeroCopyOutstanding = std::exchange(other.m_zeroCopyOutstanding, 0);
+            m_zeroCopyHeld = std::move(other.m_zeroCopyHeld);
+            m_timestamping = std::exchange(other.m_timestamping, false);
+            m_receiveTimestamp = std::exchange(other.m_receiveTimestamp, {});
+            m_transmitted = std::exchange(other.m_transmitted, {});
+            m_acknowledged = std::exchange(other.m_acknowledged, {});
         }
 
         // Move assignment
@@ -208,28 +341,119 @@ namespace Network {
                 m_protocol = std::exchange(other.m_protocol, Protocol::Unknown);
                 m_addr = std::exchange(other.m_addr, {});
                 m_isConnected = std::exchange(other.m_isConnected, false);
+                m_timeout = std::exchange(other.m_timeout, 0);
+                m_nonBlocking = std::exchange(other.m_nonBlocking, false);
+                m_zeroCopyThreshold = std::exchange(other.m_zeroCopyThreshold, 0);
+                m_zeroCopyNextId = std::exchange(other.m_zeroCopyNextId, 0);
+                m_zeroCopyStats = std::exchange(other.m_zeroCopyStats, {});
+                m_zeroCopyFirstId = std::exchange(other.m_zeroCopyFirstId, 0);
+                m_zeroCopyInFlight = std::move(other.m_zeroCopyInFlight);
+                m_zeroCopyOutstanding = std::exchange(other.m_zeroCopyOutstanding, 0);
+                m_zeroCopyHeld = std::move(other.m_zeroCopyHeld);
+                m_timestamping = std::exchange(other.m_timestamping, false);
+                m_receiveTimestamp = std::exchange(other.m_receiveTimestamp, {});
+                m_transmitted = std::exchange(other.m_transmitted, {});
+                m_acknowledged = std::exchange(other.m_acknowledged, {});
             }
             return *this;
         }
 
         void bind(uint16_t port, const char* ip = nullptr);
 
+        // unix domain stream sockets, the socket must be created with Domain::Unix,
+        // a path starting with '@' names the linux abstract namespace and never touches the filesystem
+        void bind(std::string_view path);
+
+        static bool isAbstractPath(std::string_view path) { return !path.empty() && (path[0] == '@' || path[0] == '\0'); }
+
         void listen(int backlog = s_defaultBacklog);
 
         Socket accept();
 
+        // drains up to maxCount pending connections from a non-blocking listener, stops once the backlog is empty,
+        // clients come out non-blocking and close-on-exec (accept4 on linux, so no extra syscalls per client)
+        size_t acceptBatch(std::vector<Socket>& clients, size_t maxCount);
+
+        // takes ownership of a handle accepted outside of accept(), e.g. by the io_uring backend
+        static Socket fromHandle(Handle handle, bool nonBlocking = false);
+
         void connect(const char* ip, uint16_t port);
 
+        void connect(std::string_view path);
+
         int send(const char* data, size_t len);
 
-        int sendCommited(const char* data, size_t len, size_t maxRetryCount);
+        int sendCommited(const char* data, size_t len, size_t maxRetryCount) {
+            return sendCommited(data, len, retryDeadline(maxRetryCount));
+        }
+
+        // would block waits on poll() for writability instead of sleeping, gives up once the deadline passes
+        int sendCommited(const char* data, size_t len, Deadline deadline);
+
+        int sendCommited(const std::vector<std::string_view>& buffers, size_t maxRetryCount, bool more = false) {
+            return sendCommited(buffers, retryDeadline(maxRetryCount), more);
+        }
+
+        // gathers all buffers into one writev/WSASend, more = MSG_MORE so the kernel holds a partial segment for the next write
+        int sendCommited(const std::vector<std::string_view>& buffers, Deadline deadline, bool more = false);
 
-        int sendLoop(char* buffer, size_t len, size_t totalStart, size_t maxRetryCount,
-            std::function<bool(char*&, size_t&, size_t, size_t&)> handler);
+        int sendCommited(const std::vector<std::string_view>& buffers, std::shared_ptr<void> owner,
+            size_t maxRetryCount, bool more = false) {
+            return sendCommited(buffers, std::move(owner), retryDeadline(maxRetryCount), more);
+        }
+
+        // same, but at least the zero copy threshold goes out with MSG_ZEROCOPY and the kernel reads the buffers
+        // after the call returned, the socket keeps owner (whatever keeps them alive) until it released them
+        int sendCommited(const std::vector<std::string_view>& buffers, std::shared_ptr<void> owner,
+            Deadline deadline, bool more = false);
+
+        int sendFile(int fileHandle, size_t offset, size_t len, size_t maxRetryCount) {
+            return sendFile(fileHandle, offset, len, retryDeadline(maxRetryCount));
+        }
+
+        // sends len bytes of an open file starting at offset without copying them through user space,
+        // sendfile first and splice through a pipe if the file doesn't support it (linux only)
+        int sendFile(int fileHandle, size_t offset, size_t len, Deadline deadline);
+
+        template<typename Handler>
+        int sendLoop(char* buffer, size_t len, size_t totalStart, size_t maxRetryCount, Handler&& handler) {
+            return sendLoop(buffer, len, totalStart, retryDeadline(maxRetryCount), std::forward<Handler>(handler));
+        }
+
+        // handler is any bool(char*& buffer, size_t& len, size_t bytesSent, size_t& total) callable, it runs once per write
+        // and returns false to stop, templated so it gets inlined instead of going through a std::function per syscall
+        template<typename Handler>
+        int sendLoop(char* buffer, size_t len, size_t totalStart, Deadline deadline, Handler&& handler) {
+            if (m_sockfd < 0) {
+                throw std::runtime_error("Client socket is not connected: " +
+                    getLastErrorString());
+            }
+
+            while (true) {
+                auto bytesSent = send(buffer, len);
+                if (bytesSent > 0) {
+                    deadline.progress();
+                    totalStart += bytesSent;
+                    if (!handler(buffer, len, static_cast<size_t>(bytesSent), totalStart))
+                        break;
+                }
+                else if (bytesSent == 0) {
+                    // For send(), 0 indicates an error condition
+                    throw std::runtime_error("Connection closed unexpectedly");
+                }
+                else if (!retryAfterError(true, deadline)) {
+                    break;
+                }
+            }
+            return totalStart;
+        }
 
         //returns available data size
         uint32_t checkDataAvailable();
 
+        //blocks until there is data in the queue, or a hangup/error
+        bool waitForData();
+
         //returns true if there is data in the queue, returns false when timeout expires
         template<typename Duration>
         bool waitForData(const Duration& timeout) {
@@ -238,15 +462,74 @@ namespace Network {
             return waitForData(secs, microsecs);
         }
 
+        // poll based so it works for any handle value, select() breaks past FD_SETSIZE
         bool waitForData(const std::chrono::seconds& secs, const std::chrono::microseconds& microsecs);
 
+        //waits on all sockets with a single poll, ready gets the indices of the ones with data (or a hangup/error),
+        //returns how many are ready, 0 when the timeout expires
+        template<typename Duration>
+        static size_t waitForData(std::span<Socket* const> sockets, std::vector<size_t>& ready, const Duration& timeout) {
+            return waitForData(sockets, ready, std::chrono::duration_cast<std::chrono::nanoseconds>(timeout));
+        }
+
+        static size_t waitForData(std::span<Socket* const> sockets, std::vector<size_t>& ready,
+            const std::chrono::nanoseconds& timeout);
+
         int receive(char* buffer, size_t len);
 
-        int receiveLoop(char* buffer, size_t len, size_t totalStart, size_t maxRetryCount,
-            std::function<bool(char*&, size_t&, size_t, size_t&)> handler);
+        template<typename Handler>
+        int receiveLoop(char* buffer, size_t len, size_t totalStart, size_t maxRetryCount, Handler&& handler) {
+            return receiveLoop(buffer, len, totalStart, retryDeadline(maxRetryCount), std::forward<Handler>(handler));
+        }
+
+        // would block waits on poll() for readability instead of sleeping, gives up once the deadline passes,
+        // the handler gets the same arguments as sendLoop's once per read
+        template<typename Handler>
+        int receiveLoop(char* buffer, size_t len, size_t totalStart, Deadline deadline, Handler&& handler) {
+            if (m_sockfd < 0) {
+                throw std::runtime_error("Client socket is not connected: " +
+                    getLastErrorString());
+            }
+
+            while (true) {
+                auto bytesRead = receive(buffer, len);
+                if (bytesRead > 0) {
+                    deadline.progress();
+                    totalStart += bytesRead;
+                    if (!handler(buffer, len, static_cast<size_t>(bytesRead), totalStart))
+                        break;
+                }
+                else if (bytesRead == 0) {
+                    std::cout << "Connection closed by client" << std::endl;
+                    break;
+                }
+                else if (!retryAfterError(false, deadline)) {
+                    break;
+                }
+            }
+            return totalStart;
+        }
+
+        // coroutine reads and writes, a socket that would block parks the coroutine in the context's reactor
+        // instead of holding a thread, a context without one waits on the calling thread like the blocking loops,
+        // they don't time out themselves, a session deadline shuts the socket down and ends them
+
+        // the bytes read, 0 once the peer closed
+        Task<size_t> asyncRead(IOContext& context, char* buffer, size_t len);
+
+        // sends all buffers, in as few gathered writes as the socket buffer allows
+        Task<size_t> asyncSend(IOContext& context, std::vector<std::string_view> buffers);
+
+        // ends both directions but keeps the handle, anything blocked or parked on the socket wakes up
+        // and reads the end of the stream, safe to call from another thread while the owner uses it
+        void shutdown();
 
         void close();
 
+        Handle getHandle() const { return m_sockfd; }
+
+        bool isNonBlocking() const { return m_nonBlocking; }
+
         template<typename Duration>
         Socket& setTimeout(const Duration& timeout) {
             auto secs = std::chrono::duration_cast<std::chrono::seconds>(timeout);
@@ -257,10 +540,84 @@ namespace Network {
 
         Socket& setNonBlocking(bool nonBlocking = true);
 
+        // lets several listening sockets bind the same port, the kernel spreads new connections between them (linux only)
+        Socket& setReusePort(bool reuse = true);
+
+        // steers each new connection of the reuseport group to listener (receiving cpu % groupSize),
+        // attaching it to one member applies it to the whole group (linux only)
+        Socket& setReusePortCpuSteering(uint32_t groupSize);
+
         int getReceiveBufferSize();
 
         void setReceiveBufferSize(int size);
 
+        int getSendBufferSize();
+
+        Socket& setSendBufferSize(int size);
+
+        Socket& setNoDelay(bool noDelay = true);
+
+        // holds partial segments until uncorked or 200ms pass, uncorking flushes right away (linux only)
+        Socket& setCork(bool cork = true);
+
+        // acks immediately instead of delaying, not permanent so set it again after reads that need it (linux only)
+        Socket& setQuickAck(bool quickAck = true);
+
+        // listener only, accept() returns once the client sent data or the timeout passed (linux only)
+        Socket& setDeferAccept(const std::chrono::seconds& timeout);
+
+        // listener only, lets clients with a fast open cookie send the request in the syn
+        Socket& setFastOpen(int queueLength);
+
+        // spins on the device queue for up to this long on blocking reads (linux only)
+        Socket& setBusyPoll(const std::chrono::microseconds& duration);
+
+        // how long sent data may stay unacknowledged before the connection is dropped (linux only)
+        Socket& setUserTimeout(const std::chrono::milliseconds& timeout);
+
+        // sends handed an owner of their buffers go out with MSG_ZEROCOPY from threshold bytes on,
+        // completions are read whenever the socket is waited on or sent to again (linux only)
+        Socket& setZeroCopy(size_t threshold = s_defaultZeroCopyThreshold);
+
+        bool usesZeroCopy(size_t len) const { return m_zeroCopyThreshold > 0 && len >= m_zeroCopyThreshold; }
+
+        // true while the kernel may still read from the buffers of a zero copy send
+        bool hasZeroCopyInFlight() const { return m_zeroCopyOutstanding > 0; }
+
+        // reads the completions that arrived without blocking, true once nothing is in flight
+        bool collectZeroCopy();
+
+        // blocks until every zero copy send is released, false if the deadline passed first,
+        // the buffers stay held either way, close() waits for the rest without a deadline
+        bool awaitZeroCopy(const Deadline& deadline);
+
+        // tx stamps and zero copy completions raise POLLERR, a wakeup may be nothing but one of them
+        bool usesErrorQueue() const { return m_timestamping || m_zeroCopyOutstanding > 0; }
+
+        const ZeroCopyStats& getZeroCopyStats() const { return m_zeroCopyStats; }
+
+        // software kernel timestamps for received data and for sent data leaving the host and getting acked,
+        // must be enabled before the first send since tx stamps count bytes from that point (linux only)
+        Socket& setTimestamping(bool enable = true);
+
+        bool isTimestamping() const { return m_timestamping; }
+
+        // kernel arrival time of the first bytes read since the last call, default constructed if none were stamped
+        Timestamp takeReceiveTimestamp() { return std::exchange(m_receiveTimestamp, Timestamp{}); }
+
+        // reads pending tx notifications, then fills in when the byte at offset lastByte left the host
+        // and when the peer acked it, returns true once both are known
+        bool collectTransmitTimestamps(uint32_t lastByte, Timestamp& transmitted, Timestamp& acknowledged);
+
+        // empty for sockets that aren't tcp (linux only)
+        std::optional<TcpInfo> getTcpInfo() const;
+
+        // applies the per connection fields of the profile, or the listener ones along with those its clients inherit
+        Socket& applyProfile(const Profile& profile, bool listener = false);
+
+        // the part of the profile a client accepted from this listener still needs on its own socket
+        Profile clientProfile(const Profile& profile) const;
+
         static Error getLastError();
 
         static std::string getErrorString(Error error);
@@ -0,0 +1,148 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+// lazily started coroutine, the body only runs once the task is awaited and whoever awaited it
+// resumes on the thread the task finished on, usually the pool thread its socket became ready on
+template<typename T = void>
+class Task;
+
+namespace TaskDetail
+{
+    struct TaskPromiseBase
+    {
+        // hands control back to the awaiting coroutine, symmetric transfer keeps long chains of
+        // tasks that finish synchronously off the stack
+        struct FinalAwaiter
+        {
+            bool await_ready() const noexcept { return false; }
+
+            template<typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+                return handle.promise().continuation;
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+        std::exception_ptr exception;
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    template<typename T>
+    struct TaskPromise : TaskPromiseBase
+    {
+        std::optional<T> value;
+
+        Task<T> get_return_object();
+
+        template<typename U>
+        void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+
+        T result() {
+            if (exception)
+                std::rethrow_exception(exception);
+            return std::move(*value);
+        }
+    };
+
+    template<>
+    struct TaskPromise<void> : TaskPromiseBase
+    {
+        Task<void> get_return_object();
+
+        void return_void() {}
+
+        void result() {
+            if (exception)
+                std::rethrow_exception(exception);
+        }
+    };
+
+    // fire and forget frame, starts right away and frees itself once the body returns,
+    // the body has to catch everything itself
+    struct DetachedTask
+    {
+        struct promise_type
+        {
+            DetachedTask get_return_object() { return {}; }
+            std::suspend_never initial_suspend() const noexcept { return {}; }
+            std::suspend_never final_suspend() const noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+}
+
+template<typename T>
+class Task
+{
+public:
+    using promise_type = TaskDetail::TaskPromise<T>;
+
+    struct Awaiter
+    {
+        std::coroutine_handle<promise_type> handle;
+
+        bool await_ready() const noexcept { return !handle || handle.done(); }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            handle.promise().continuation = awaiting;
+            return handle;
+        }
+
+        T await_resume() {
+            if (!handle)
+                throw std::runtime_error("Awaiting an empty task");
+            return handle.promise().result();
+        }
+    };
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+
+public:
+    explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (m_handle)
+                m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    bool valid() const { return m_handle != nullptr; }
+
+    Awaiter operator co_await() const noexcept { return Awaiter{ m_handle }; }
+};
+
+namespace TaskDetail
+{
+    template<typename T>
+    Task<T> TaskPromise<T>::get_return_object() {
+        return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+    }
+
+    inline Task<void> TaskPromise<void>::get_return_object() {
+        return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+    }
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "Common.h"
+#include "WorkStealingPool.h"
+
+// hierarchical timing wheel, arming and cancelling a timer is O(1) no matter how many are armed,
+// so every connection can keep a deadline of its own
+// 4 levels of 64 slots, level 0 has one slot per tick and every higher level one per full turn of the level below,
+// timers cascade down a level each time the level below wraps, expired callbacks run on the pool
+class TimerWheel
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+
+    static constexpr std::chrono::milliseconds s_defaultResolution{ 10 };
+    static constexpr size_t s_levelBits = 6;
+    static constexpr size_t s_slotsPerLevel = size_t(1) << s_levelBits;
+    static constexpr size_t s_levelCount = 4;
+    static constexpr uint64_t s_maxTicks = uint64_t(1) << (s_levelBits * s_levelCount); // ~46h at 10ms, longer ones fire then
+
+    // generation tells a reused slot from the timer it used to hold, cancelling a fired timer is a no-op
+    struct Id
+    {
+        uint32_t index = UINT32_MAX;
+        uint32_t generation = 0;
+
+        bool valid() const { return index != UINT32_MAX; }
+    };
+
+private:
+    static constexpr uint32_t s_none = UINT32_MAX;
+
+    struct Node
+    {
+        uint64_t expiry = 0; //in ticks
+        uint32_t previous = s_none;
+        uint32_t next = s_none;
+        uint32_t generation = 0;
+        uint32_t slot = s_none; //level * s_slotsPerLevel + slot while armed
+        Callback callback;
+    };
+
+    WorkStealingPool& m_pool;
+    std::thread m_thread;
+    std::atomic<bool> m_shouldRun = false;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+
+    const std::chrono::milliseconds m_resolution;
+    const Clock::time_point m_start = Clock::now();
+    uint64_t m_now = 0;                  //last tick processed
+    uint64_t m_sleepUntil = UINT64_MAX;  //tick the loop waits for
+    size_t m_armed = 0;
+
+    std::vector<Node> m_nodes;           //slab, freed nodes chain through next
+    uint32_t m_free = s_none;
+    std::array<uint32_t, s_slotsPerLevel * s_levelCount> m_slots;
+
+    void loop();
+    uint64_t currentTick() const;
+    uint64_t nextTick() const;
+
+    void link(uint32_t index);
+    void unlink(uint32_t index);
+    void release(uint32_t index);
+    void cascade(size_t level);
+    void advance(uint64_t target, std::vector<Callback>& expired);
+
+public:
+    TimerWheel(WorkStealingPool& pool, std::chrono::milliseconds resolution = s_defaultResolution);
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    void start();
+    void stop();
+
+    // the callback runs on the pool once the timeout passed, rounded up to the next tick
+    Id arm(std::chrono::milliseconds timeout, Callback callback);
+
+    // false if the timer already fired or was cancelled, the id is reset either way
+    bool cancel(Id& id);
+
+    size_t size();
+};
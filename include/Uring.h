@@ -0,0 +1,143 @@
+#pragma once
+#include "Common.h"
+#include "Socket.h"
+#include "Reactor.h"
+
+// io_uring backend, linux 6.0+ (multishot receive)
+// completions are reaped on a single ring thread, accept and receive callbacks run there directly
+// (so multishot results arrive in order), wait and send callbacks are handed to the pool
+class Uring
+{
+public:
+    using WaitCallback = Reactor::WaitCallback;
+    using AcceptCallback = std::function<void(Network::Socket::Handle)>;
+    using ReceiveCallback = std::function<bool(const char*, size_t)>; //empty data on close or error, return false to stop receiving
+    using DoneCallback = std::function<void()>; //runs once no more data can arrive
+    using SendCallback = std::function<void(int)>; //bytes sent or negative error code
+    using Clock = Reactor::Clock;
+
+    static constexpr unsigned s_queueDepth = 4096;
+    static constexpr unsigned s_bufferCount = 1024; //power of two
+    static constexpr unsigned s_bufferSize = 4096;
+    static constexpr uint16_t s_bufferGroup = 0;
+
+private:
+    struct Operation
+    {
+        enum class Type {
+            Wait,
+            Accept,
+            Receive,
+            Send,
+        };
+
+        Type type;
+        Network::Socket::Handle handle;
+        std::atomic<bool> cancelled = false;
+        bool stopRequested = false; //ring thread only
+
+        WaitCallback waitCallback;
+        AcceptCallback acceptCallback;
+        ReceiveCallback receiveCallback;
+        DoneCallback doneCallback;
+        SendCallback sendCallback;
+
+        int64_t timeout[2] = { 0, 0 }; //__kernel_timespec, has to live until submission
+        size_t pendingSends = 0;
+        int sendResult = 0;
+    };
+
+    WorkStealingPool& m_pool;
+    std::thread m_thread;
+    std::atomic<bool> m_shouldRun = false;
+
+    int m_ringHandle = -1;
+
+    // ring mappings
+    void* m_submissionRing = nullptr;
+    size_t m_submissionRingSize = 0;
+    void* m_completionRing = nullptr;
+    size_t m_completionRingSize = 0;
+    void* m_submissionEntries = nullptr;
+    size_t m_submissionEntriesSize = 0;
+
+    uint32_t* m_submissionHead = nullptr;
+    uint32_t* m_submissionTail = nullptr;
+    uint32_t m_submissionMask = 0;
+    uint32_t m_submissionEntryCount = 0;
+    uint32_t m_localTail = 0;
+
+    uint32_t* m_completionHead = nullptr;
+    uint32_t* m_completionTail = nullptr;
+    uint32_t m_completionMask = 0;
+    void* m_completionEntries = nullptr;
+
+    // provided receive buffers, handed back to the kernel by the ring thread once consumed
+    std::vector<char> m_buffers;
+    bool m_recycled = false; //ring thread only, recycled buffers wait for the next submission
+
+    // operations and their callbacks are only released by the ring thread, after their final completion
+    std::mutex m_submitMutex; //the submission queue has a single producer
+    std::mutex m_mutex; //guards m_operations
+    std::unordered_map<Network::Socket::Handle, std::vector<Operation*>> m_operations;
+
+    void setupRings();
+    void setupBuffers();
+    void probeReceive();
+    void release();
+
+    void* getEntry(std::unique_lock<std::mutex>& submitLock);
+    void submit(std::unique_lock<std::mutex>& submitLock);
+
+    void track(Operation* op);
+    void finish(Operation* op);
+
+    void prepareAccept(Operation* op);
+    void prepareReceive(Operation* op);
+    void cancelOperation(Operation* op);
+
+    void recycleBuffer(uint16_t bufferId);
+    void complete(uint64_t userData, int result, uint32_t flags, std::vector<std::function<void()>>& ready);
+    void loop();
+
+public:
+    Uring(WorkStealingPool& pool);
+    ~Uring();
+
+    Uring(const Uring&) = delete;
+    Uring& operator=(const Uring&) = delete;
+
+    void start();
+    void stop();
+
+    // the loop thread, sharded contexts pin it next to the pool
+    std::thread& getThread() { return m_thread; }
+
+    // same contract as Reactor::asyncWait, implemented with a poll request linked to a timeout
+    void asyncWait(Network::Socket::Handle handle, Reactor::Event event, WaitCallback callback);
+
+    template<typename Duration>
+    void asyncWait(Network::Socket::Handle handle, Reactor::Event event,
+        const Duration& timeout, WaitCallback callback) {
+        asyncWait(handle, event, Clock::now() +
+            std::chrono::duration_cast<Clock::duration>(timeout), std::move(callback));
+    }
+
+    void asyncWait(Network::Socket::Handle handle, Reactor::Event event,
+        Clock::time_point deadline, WaitCallback callback);
+
+    // multishot accept, one request keeps producing non-blocking client handles until cancelled
+    void asyncAccept(Network::Socket::Handle listenHandle, AcceptCallback callback);
+
+    // multishot receive into the provided buffer ring, data is only valid during the callback
+    void asyncReceive(Network::Socket::Handle handle, ReceiveCallback callback, DoneCallback done);
+
+    // buffers are sent as linked requests in one submission, they must stay alive until the callback
+    void asyncSend(Network::Socket::Handle handle, const std::vector<std::string_view>& buffers,
+        SendCallback callback);
+
+    // pending requests are dropped without being invoked, must be called before the handle is closed
+    void cancel(Network::Socket::Handle handle);
+
+    bool isRunning() const { return m_shouldRun.load(); }
+};
@@ -0,0 +1,118 @@
+#pragma once
+#include "Common.h"
+
+#include <deque>
+
+// thread pool without a shared lock on the hot path, every worker owns a Chase-Lev deque and a LIFO slot,
+// threads outside the pool submit through one injection queue
+// a task pushed from a worker lands in that worker's LIFO slot and runs next on the same thread while what it
+// touched is still in cache, the task it displaces moves to the worker's deque
+// idle workers look at their slot, their deque and the injection queue, then steal from the other workers,
+// slots included, so a worker stuck in a blocking task (the blocking backend's sessions) never strands its queue
+class WorkStealingPool
+{
+public:
+    using Task = std::function<void()>;
+
+    struct Stats
+    {
+        size_t executed = 0;
+        size_t lifo = 0;     // ran straight from the LIFO slot of the worker that pushed them
+        size_t injected = 0; // came through the injection queue
+        size_t stolen = 0;   // taken from another worker
+    };
+
+    // a worker checks the injection queue first every this many tasks, so its own work can't starve submitters
+    static constexpr size_t s_injectionInterval = 61;
+    // consecutive LIFO slot tasks before the deque gets a turn, a task chain can't starve the tasks it displaced
+    static constexpr size_t s_maxLifoStreak = 16;
+
+private:
+    // the owner pushes and pops at the bottom, thieves take from the top
+    class Deque
+    {
+        struct Buffer
+        {
+            int64_t capacity;
+            std::unique_ptr<std::atomic<Task*>[]> slots;
+
+            explicit Buffer(int64_t capacity) : capacity(capacity), slots(new std::atomic<Task*>[capacity]) {}
+
+            Task* get(int64_t index) const { return slots[index & (capacity - 1)].load(std::memory_order_relaxed); }
+            void put(int64_t index, Task* task) { slots[index & (capacity - 1)].store(task, std::memory_order_relaxed); }
+        };
+
+        std::atomic<int64_t> m_top = 0;
+        std::atomic<int64_t> m_bottom = 0;
+        std::atomic<Buffer*> m_buffer;
+        std::vector<std::unique_ptr<Buffer>> m_buffers; // outgrown ones stay alive, a thief may still read them
+
+        Buffer* grow(Buffer* buffer, int64_t top, int64_t bottom);
+
+    public:
+        explicit Deque(int64_t capacity = 256);
+
+        void push(Task* task);
+        Task* pop();
+        Task* steal();
+
+        bool empty() const {
+            return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+        }
+    };
+
+    struct alignas(64) Worker
+    {
+        Deque deque;
+        std::atomic<Task*> lifo = nullptr;
+        std::thread thread;
+        size_t lifoStreak = 0;
+        uint64_t victimSeed = 0;
+
+        std::atomic<size_t> executed = 0;
+        std::atomic<size_t> lifoCount = 0;
+        std::atomic<size_t> injectedCount = 0;
+        std::atomic<size_t> stolenCount = 0;
+    };
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<bool> m_active = false;
+
+    std::mutex m_injectionMutex;
+    std::deque<Task*> m_injected;
+    std::atomic<size_t> m_injectedSize = 0;
+
+    // bumped by every push, sleeping workers wait for it to change
+    std::atomic<uint64_t> m_signal = 0;
+    std::atomic<size_t> m_sleeping = 0;
+
+    void workerLoop(size_t index);
+    Task* findTask(Worker& worker, size_t index, size_t tick);
+    Task* popInjected();
+    Task* steal(Worker& worker, size_t index);
+    void run(Worker& worker, Task* task);
+    void notify();
+
+public:
+    WorkStealingPool() = default;
+    explicit WorkStealingPool(size_t threadCount) { init(threadCount); }
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void init(size_t threadCount);
+
+    // stops taking tasks and joins the workers once their current task returns, queued tasks are dropped
+    void shutdown();
+
+    // false once the pool is shut down
+    bool pushTask(Task task);
+
+    size_t getWorkerCount() const { return m_workers.size(); }
+
+    // true on the pool's own workers
+    bool isWorkerThread() const;
+
+    Stats getStats() const;
+};
@@ -2,10 +2,18 @@
 #define assert(x) if(!(x)) throw std::runtime_error("Assertion failed: " #x);
 
 #include "TaskManager.h"
+#include "LoopBenchmark.h"
 
-int main()
+int main(int argc, char** argv)
 {
-	Network::HTTP::RestfulServer server(8080, "RestfulServer");
+	if (argc > 1 && std::string_view(argv[1]) == "loopbench") {
+		LoopBenchmark().run();
+		return 0;
+	}
+
+	// backend can be picked on the command line (blocking, epoll, io_uring) to compare them
+	auto backend = IOContext::backendFromString(argc > 1 ? argv[1] : "blocking");
+	Network::HTTP::RestfulServer server(8080, "RestfulServer", Network::HTTP::RestfulServer::CorsOptions{}, backend);
 	TaskManager taskManager;
 	taskManager.registerRoutes(server);
 	server.start();
@@ -1,135 +1,107 @@
 #include "../include/Body.h"
+#include "../include/ChunkedDecoder.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace Network::HTTP
 {
-    size_t StringBody::readTransferSize(Socket& sock,
-        std::string& leftovers, size_t size, size_t maxRetryCount,
-        size_t maxBodySize)
+    void FileBody::openHandle()
     {
-        size_t bytesRead = leftovers.size();
+#ifndef _WIN32
+        m_fileHandle = ::open(m_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (m_fileHandle < 0)
+            throw std::runtime_error("Cannot open file for sending: " + Socket::getLastErrorString());
+#endif
+    }
 
-        if (size > maxBodySize) {
-            throw std::runtime_error("Content size exceeds maximum allowed ("
-                + std::to_string(size / 1024) + "KB > "
-                + std::to_string(maxBodySize / 1024) + "KB)");
-        }
+    FileBody::~FileBody()
+    {
+#ifndef _WIN32
+        if (m_fileHandle >= 0)
+            ::close(m_fileHandle);
+#endif
+    }
 
-        if (!leftovers.empty())
-        {
-            if (leftovers.size() > size) {
-                throw std::runtime_error("Leftover data size exceeds expected content size");
-            }
-            else if (leftovers.size() == size) {
-                m_data = leftovers;
-                return bytesRead;
-            }
-            m_data = leftovers;
-        }
-        else m_data.resize(size);        
+    size_t Body::readChunked(Socket& sock, std::string& leftovers,
+        size_t maxRetryCount, size_t maxBodySize)
+    {
+        ChunkedDecoder decoder(maxBodySize);
+        size_t bytesRead = 0;
 
         try
         {
-            sock.receiveLoop(m_data.data() + leftovers.size(),
-                m_data.size() - leftovers.size(), leftovers.size(), maxRetryCount,
-                [this]
-                (char*& buffer, size_t& len, size_t bytesRead, size_t& receivedTotal) {
-                    if (receivedTotal > m_data.size()) {  // Add overflow check
-                        throw std::runtime_error("Received more data than expected");
-                    }
-                    if (receivedTotal == m_data.size())
+            // the whole body may have arrived with the header
+            leftovers.erase(0, decoder.decode(leftovers, *this));
+            if (decoder.isComplete())
+                return 0;
+
+            // consumed bytes are dropped after every receive, what stays is at most an unfinished line,
+            // so payload is copied once from the receive into the body and the buffer doesn't grow with it
+            size_t buffered = leftovers.size();
+            leftovers.resize(buffered + s_chunkedReceiveSize);
+            buffered = sock.receiveLoop(leftovers.data() + buffered,
+                leftovers.size() - buffered, buffered, maxRetryCount,
+                [this, &decoder, &leftovers, &bytesRead]
+                (char*& buffer, size_t& len, size_t received, size_t& receivedTotal) {
+                    bytesRead += received;
+                    size_t consumed = decoder.decode(std::string_view(leftovers.data(), receivedTotal), *this);
+                    leftovers.erase(0, consumed);
+                    receivedTotal -= consumed;
+                    if (decoder.isComplete())
                         return false;
-                    buffer = m_data.data() + receivedTotal;
-                    len = m_data.size() - receivedTotal;
+
+                    if (leftovers.size() < receivedTotal + s_chunkedReceiveSize)
+                        leftovers.resize(receivedTotal + s_chunkedReceiveSize);
+                    buffer = leftovers.data() + receivedTotal;
+                    len = leftovers.size() - receivedTotal;
                     return true;
                 }
             );
+            leftovers.resize(buffered);
         }
         catch (const std::exception& e)
         {
-            m_data.clear();
             throw std::runtime_error(std::string("Body parse error: ") + e.what());
         }
 
+        if (!decoder.isComplete())
+            throw std::runtime_error("Body parse error: connection closed in the middle of a chunked body");
         return bytesRead;
     }
 
-    size_t StringBody::readChunked(Socket& sock, std::string& leftovers,
-        size_t maxRetryCount, size_t maxBodySize)
+    size_t StringBody::readTransferSize(Socket& sock,
+        std::string& leftovers, size_t size, size_t maxRetryCount,
+        size_t maxBodySize)
     {
-        size_t bytesInitial = leftovers.size();
-
-        size_t chunksReceived = 0;
-        size_t chunkSize = 0;
-        size_t chunkStart = 0;
-        size_t displacementCounter = 0;
-        size_t cursor = 0;
-        bool isInChunk = false;
-        bool isParsingHex = false;
-        std::string hexBuffer;
-
-        if (!leftovers.empty())
-            m_data = leftovers;
+        if (size > maxBodySize) {
+            throw std::runtime_error("Content size exceeds maximum allowed ("
+                + std::to_string(size / 1024) + "KB > "
+                + std::to_string(maxBodySize / 1024) + "KB)");
+        }
 
-        m_data.resize(1024);
+        // a pipelined request may follow the body in leftovers, only this body's bytes are taken
+        size_t buffered = std::min(size, leftovers.size());
+        m_data.assign(leftovers, 0, buffered);
+        leftovers.erase(0, buffered);
+        if (buffered == size)
+            return 0;
 
+        m_data.resize(size);
+        size_t receivedTotal = buffered;
         try
         {
-            sock.receiveLoop(m_data.data() + leftovers.size(),
-                m_data.size() - leftovers.size(), leftovers.size(), maxRetryCount,
-                [this, &maxBodySize, &cursor, &displacementCounter, &chunkStart,
-                &isInChunk, &hexBuffer, &isParsingHex, &chunkSize, &chunksReceived]
+            receivedTotal = sock.receiveLoop(m_data.data() + buffered,
+                m_data.size() - buffered, buffered, maxRetryCount,
+                [this]
                 (char*& buffer, size_t& len, size_t bytesRead, size_t& receivedTotal) {
-                    for (cursor; cursor < receivedTotal; cursor++)
-                    {
-                        if (isParsingHex)
-                        {
-                            if (m_data[cursor] != '\r')
-                                hexBuffer += m_data[cursor];
-                            else
-                            {
-                                isParsingHex = false;
-                                cursor += 1;
-                                chunkSize = Detail::hexToDec(hexBuffer);
-                                displacementCounter += hexBuffer.size() + 4;
-                                hexBuffer.clear();
-                                if (chunkSize == 0)
-                                {
-                                    receivedTotal -= displacementCounter;
-                                    m_data.resize(receivedTotal);
-                                    return false;
-                                }
-                                chunksReceived++;
-                                chunkStart = cursor + 1;
-                            }
-                        }
-                        else if (m_data[cursor] == '\r')
-                        {
-                            if (cursor - chunkStart - 1 != chunkSize)
-                                throw std::runtime_error("Chunk size: " + std::to_string(cursor - chunkStart - 1) +
-                                    " doesn't match expected size: " + std::to_string(chunkSize));
-                            cursor += 1;
-                            isParsingHex = true;
-                        }
-                        else
-                        {
-                            m_data[cursor - displacementCounter] = m_data[cursor];
-                        }
-                    }
-
-                    receivedTotal -= displacementCounter;
-                    cursor -= displacementCounter;
-                    displacementCounter = 0;
-
-                    if (receivedTotal > maxBodySize) {
-                        throw std::runtime_error("Content size exceeds maximum allowed ("
-                            + std::to_string(receivedTotal / 1024) + "KB > "
-                            + std::to_string(maxBodySize / 1024) + "KB)");
-                    }
-
-                    if (m_data.size() - receivedTotal < 256) {
-                        m_data.resize(m_data.size() * 2);
+                    if (receivedTotal > m_data.size()) {  // Add overflow check
+                        throw std::runtime_error("Received more data than expected");
                     }
-
+                    if (receivedTotal == m_data.size())
+                        return false;
                     buffer = m_data.data() + receivedTotal;
                     len = m_data.size() - receivedTotal;
                     return true;
@@ -142,52 +114,51 @@ namespace Network::HTTP
             throw std::runtime_error(std::string("Body parse error: ") + e.what());
         }
 
-        return m_data.size() - bytesInitial;
+        if (receivedTotal < size)
+            throw std::runtime_error("Body parse error: connection closed after "
+                + std::to_string(receivedTotal) + " of " + std::to_string(size) + " bytes");
+        return size - buffered;
     }
 
     size_t FileBody::readTransferSize(Socket& sock,
         std::string& leftovers, size_t size, size_t maxRetryCount,
         size_t maxBodySize)
     {
-        size_t bytesRead = leftovers.size() - size;
-
         if (size > maxBodySize) {
             throw std::runtime_error("Content size exceeds maximum allowed ("
                 + std::to_string(size / 1024) + "KB > "
                 + std::to_string(maxBodySize / 1024) + "KB)");
         }
 
-        if (!leftovers.empty())
-        {
-            if (leftovers.size() > size) {
-                throw std::runtime_error("Leftover data size exceeds expected content size");
-            }
-            m_file << leftovers;
-        }
+        // a pipelined request may follow the body in leftovers, only this body's bytes are taken
+        size_t buffered = std::min(size, leftovers.size());
+        m_file.write(leftovers.data(), buffered);
+        leftovers.erase(0, buffered);
+        m_size += buffered;
 
-        m_size = leftovers.size();
-        leftovers.resize(1024);
+        size_t remaining = size - buffered;
+        if (remaining == 0)
+            return 0;
 
+        // never asks for more than the body still needs, so nothing of the next request ends up in the file
+        std::vector<char> buffer(std::min<size_t>(remaining, 1024 * 16));
+        size_t receivedTotal = 0;
         try
         {
-            m_size = sock.receiveLoop(leftovers.data(),
-                leftovers.size(), m_size, maxRetryCount,
-                [this, &size, &leftovers]
-                (char*& buffer, size_t& len, size_t bytesRead, size_t& receivedTotal) {
-                    if (receivedTotal > size) {  // Add overflow check
-                        throw std::runtime_error("Received more data than expected");
-                    }
-                    if (receivedTotal == size)
+            receivedTotal = sock.receiveLoop(buffer.data(),
+                std::min(buffer.size(), remaining), 0, maxRetryCount,
+                [this, &buffer, remaining]
+                (char*& chunk, size_t& len, size_t bytesRead, size_t& receivedTotal) {
+                    m_file.write(chunk, bytesRead);
+                    m_size += bytesRead;
+                    if (receivedTotal >= remaining)
                         return false;
 
-                    m_file << leftovers.substr(0, bytesRead);
-                    buffer = leftovers.data();
-                    len = leftovers.size();
+                    chunk = buffer.data();
+                    len = std::min(buffer.size(), remaining - receivedTotal);
                     return true;
                 }
             );
-
-
         }
         catch (const std::exception& e)
         {
@@ -195,101 +166,10 @@ namespace Network::HTTP
             throw std::runtime_error(std::string("Body parse error: ") + e.what());
         }
 
-        return bytesRead;
-    }
-
-    size_t FileBody::readChunked(Socket& sock, std::string& leftovers,
-        size_t maxRetryCount, size_t maxBodySize)
-    {
-
-        size_t chunksReceived = 0;
-        size_t chunkSize = 0;
-        size_t chunkStart = 0;
-        size_t displacementCounter = 0;
-        size_t cursor = 0;
-        bool isInChunk = false;
-        bool isParsingHex = false;
-        std::string hexBuffer;
-        size_t initSize;
-
-        initSize = leftovers.size();
-        leftovers.resize(1024);
-        m_file.seekp(0, std::ios::end);
-
-        try
-        {
-            sock.receiveLoop(leftovers.data() + initSize,
-                leftovers.size() - initSize, initSize, maxRetryCount,
-                [this, &maxBodySize, &cursor, &displacementCounter, &chunkStart,
-                &isInChunk, &hexBuffer, &isParsingHex, &chunkSize, &chunksReceived,
-                &leftovers, &initSize]
-                (char*& buffer, size_t& len, size_t bytesRead, size_t& receivedTotal) {
-                    for (cursor; cursor < receivedTotal; cursor++)
-                    {
-                        if (isParsingHex)
-                        {
-                            if (leftovers[cursor] != '\r')
-                                hexBuffer += leftovers[cursor];
-                            else
-                            {
-                                isParsingHex = false;
-                                cursor += 1;
-                                chunkSize = Detail::hexToDec(hexBuffer);
-                                displacementCounter += hexBuffer.size() + 4;
-                                hexBuffer.clear();
-                                if (chunkSize == 0)
-                                {
-                                    receivedTotal -= displacementCounter;
-                                    cursor -= displacementCounter;
-                                    m_file << leftovers.substr(0, cursor);
-                                    initSize = receivedTotal;
-                                    return false;
-                                }
-                                chunksReceived++;
-                                chunkStart = cursor + 1;
-                            }
-                        }
-                        else if (leftovers[cursor] == '\r')
-                        {
-                            if (cursor - chunkStart - 1 != chunkSize)
-                                throw std::runtime_error("Chunk size: " + std::to_string(cursor - chunkStart - 1) +
-                                    " doesn't match expected size: " + std::to_string(chunkSize));
-                            cursor += 1;
-                            isParsingHex = true;
-                        }
-                        else
-                        {
-                            leftovers[cursor - displacementCounter] = leftovers[cursor];
-                        }
-                    }
-
-                    receivedTotal -= displacementCounter;
-                    cursor -= displacementCounter;
-                    displacementCounter = 0;
-
-                    if (receivedTotal > maxBodySize) {
-                        throw std::runtime_error("Content size exceeds maximum allowed ("
-                            + std::to_string(receivedTotal / 1024) + "KB > "
-                            + std::to_string(maxBodySize / 1024) + "KB)");
-                    }
-
-                    if (leftovers.size() - receivedTotal < 256) {
-                        cursor = 0;
-                        m_file << leftovers.substr(0, receivedTotal);
-                    }
-
-                    buffer = leftovers.data() + cursor;
-                    len = leftovers.size() - cursor;
-                    return true;
-                }
-            );
-        }
-        catch (const std::exception& e)
-        {
-            m_file.clear();
-            throw std::runtime_error(std::string("Body parse error: ") + e.what());
-        }
-        return initSize;
+        if (receivedTotal < remaining)
+            throw std::runtime_error("Body parse error: connection closed after "
+                + std::to_string(buffered + receivedTotal) + " of " + std::to_string(size) + " bytes");
+        return receivedTotal;
     }
 
     size_t StringBody::sendTransferSize(Socket& sock, size_t size,
@@ -318,6 +198,16 @@ namespace Network::HTTP
     size_t FileBody::sendTransferSize(Socket& sock, size_t size,
         size_t maxRetryCount, size_t maxBodySize)
     {
+#ifndef _WIN32
+        if (m_size == 0)
+            throw std::runtime_error("Body has no content to send");
+        if (maxBodySize < m_size)
+            throw std::runtime_error("Body send error: Body size exceeds maximum allowed size");
+
+        // received bodies may still sit in the stream buffer, the kernel reads the file itself
+        m_file.flush();
+        return sock.sendFile(m_fileHandle, 0, std::min(size, m_size), maxRetryCount);
+#else
         std::cout << "Sending body transfer size: " << std::endl;
 
         m_file.seekg(0, std::ios::beg);
@@ -358,6 +248,7 @@ namespace Network::HTTP
         {
             throw std::runtime_error(std::string("Body send error: ") + e.what());
         }
+#endif
     }
 
     size_t FileBody::sendChunked(Socket& sock, size_t maxRetryCount,
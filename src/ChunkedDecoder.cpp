@@ -0,0 +1,120 @@
+#include "../include/ChunkedDecoder.h"
+
+#include <charconv>
+#include <cstring>
+
+namespace Network::HTTP
+{
+    namespace
+    {
+        // next line at or after position without its line break, position moves past it, false if it isn't complete
+        bool nextLine(std::string_view data, size_t& position, std::string_view& line)
+        {
+            if (position == data.size())
+                return false;
+
+            auto lineFeed = static_cast<const char*>(std::memchr(data.data() + position, '\n', data.size() - position));
+            if (lineFeed == nullptr)
+                return false;
+
+            size_t end = lineFeed - data.data();
+            line = data.substr(position, end - position);
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+            position = end + 1;
+            return true;
+        }
+    }
+
+    void ChunkedDecoder::parseSizeLine(std::string_view line)
+    {
+        size_t chunkSize = 0;
+        auto [end, error] = std::from_chars(line.data(), line.data() + line.size(), chunkSize, 16);
+        if (error == std::errc::result_out_of_range)
+            throw std::runtime_error("Chunk size out of range: " + std::string(line));
+        if (error != std::errc())
+            throw std::runtime_error("Invalid chunk size: " + std::string(line));
+
+        // whitespace may precede the extensions, nothing else may follow the digits
+        std::string_view rest(end, line.data() + line.size() - end);
+        size_t extensions = rest.find_first_not_of(" \t");
+        if (extensions != std::string_view::npos && rest[extensions] != ';')
+            throw std::runtime_error("Invalid chunk size: " + std::string(line));
+
+        if (chunkSize > m_maxBodySize - m_bodySize) {
+            throw std::runtime_error("Chunked body exceeds maximum allowed ("
+                + std::to_string(m_maxBodySize / 1024) + "KB)");
+        }
+
+        m_bodySize += chunkSize;
+        m_remaining = chunkSize;
+        m_state = chunkSize == 0 ? State::Trailers : State::Data;
+    }
+
+    size_t ChunkedDecoder::decode(std::string_view data, Body& body)
+    {
+        size_t position = 0;
+        std::string_view line;
+
+        while (m_state != State::Complete)
+        {
+            switch (m_state)
+            {
+            case State::Size:
+                if (!nextLine(data, position, line)) {
+                    if (data.size() - position > s_maxSizeLineLength)
+                        throw std::runtime_error("Chunk size line too long");
+                    return position;
+                }
+                if (line.empty())
+                    throw std::runtime_error("Missing chunk size");
+                parseSizeLine(line);
+                break;
+
+            case State::Data:
+            {
+                size_t part = std::min(m_remaining, data.size() - position);
+                if (part == 0)
+                    return position;
+                body.append(data.data() + position, part);
+                position += part;
+                m_remaining -= part;
+                if (m_remaining == 0)
+                    m_state = State::DataEnd;
+                break;
+            }
+
+            case State::DataEnd:
+                if (data.size() - position < 2) {
+                    if (position < data.size() && data[position] != '\r')
+                        throw std::runtime_error("Chunk data longer than its size");
+                    return position;
+                }
+                if (data[position] != '\r' || data[position + 1] != '\n')
+                    throw std::runtime_error("Chunk data longer than its size");
+                position += 2;
+                m_state = State::Size;
+                break;
+
+            case State::Trailers:
+                if (!nextLine(data, position, line)) {
+                    if (m_trailerSize + data.size() - position > s_maxHeaderSize)
+                        throw std::runtime_error("Chunked trailers too large");
+                    return position;
+                }
+                if (line.empty()) {
+                    m_state = State::Complete;
+                    break;
+                }
+                m_trailerSize += line.size() + 2;
+                if (m_trailerSize > s_maxHeaderSize)
+                    throw std::runtime_error("Chunked trailers too large");
+                break;
+
+            default:
+                break;
+            }
+        }
+        return position;
+    }
+}
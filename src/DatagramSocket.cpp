@@ -0,0 +1,251 @@
+#include "../include/DatagramSocket.h"
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <arpa/inet.h>
+#include <errno.h>
+#endif
+
+namespace Network {
+
+#ifdef _WIN32
+
+    // recvmmsg/sendmmsg are linux only
+    struct DatagramSocket::Batch::Native {};
+
+    DatagramSocket::Batch::Batch(size_t capacity, size_t slotSize) :
+        m_capacity(capacity), m_slotSize(slotSize) {
+        throw std::runtime_error("Datagram batches are not supported on this platform");
+    }
+
+    DatagramSocket::Batch::~Batch() = default;
+    DatagramSocket::Batch::Batch(Batch&&) noexcept = default;
+    DatagramSocket::Batch& DatagramSocket::Batch::operator=(Batch&&) noexcept = default;
+
+    std::string_view DatagramSocket::Batch::data(size_t index) const { return {}; }
+    Socket::AddressIn DatagramSocket::Batch::address(size_t index) const { return {}; }
+    size_t DatagramSocket::Batch::segmentSize(size_t index) const { return 0; }
+    bool DatagramSocket::Batch::push(std::string_view payload, const AddressIn* to) { return false; }
+
+    DatagramSocket::DatagramSocket(Domain domain) : Socket(domain, Type::Dgram, Protocol::UDP) {
+        throw std::runtime_error("DatagramSocket is not supported on this platform");
+    }
+
+    Socket::AddressIn DatagramSocket::makeAddress(const char* ip, uint16_t port) { return {}; }
+    size_t DatagramSocket::receiveBatch(Batch& batch) { return 0; }
+    size_t DatagramSocket::sendBatch(Batch& batch, size_t first) { return 0; }
+    bool DatagramSocket::setSegmentSize(uint16_t segmentSize) { return false; }
+    bool DatagramSocket::setReceiveOffload(bool enable) { return false; }
+    void DatagramSocket::asyncReceive(IOContext& context, Batch& batch, ReceiveHandler handler) {}
+
+#else
+
+    static constexpr size_t s_controlSize = CMSG_SPACE(sizeof(int)); // room for the UDP_GRO segment size
+
+    struct DatagramSocket::Batch::Native {
+        std::vector<char> storage;
+        std::vector<mmsghdr> headers;
+        std::vector<iovec> vectors;
+        std::vector<sockaddr_in> addresses;
+        std::vector<char> control;
+        std::vector<size_t> segmentSizes;
+    };
+
+    DatagramSocket::Batch::Batch(size_t capacity, size_t slotSize) :
+        m_native(std::make_unique<Native>()),
+        m_capacity(std::min(capacity, s_maxBatchSize)), m_slotSize(slotSize)
+    {
+        if (m_capacity == 0 || m_slotSize == 0)
+            throw std::runtime_error("Datagram batch needs at least one slot");
+
+        m_native->storage.resize(m_capacity * m_slotSize);
+        m_native->headers.resize(m_capacity);
+        m_native->vectors.resize(m_capacity);
+        m_native->addresses.resize(m_capacity);
+        m_native->control.resize(m_capacity * s_controlSize);
+        m_native->segmentSizes.resize(m_capacity);
+
+        for (size_t i = 0; i < m_capacity; i++) {
+            m_native->vectors[i] = iovec{ m_native->storage.data() + i * m_slotSize, m_slotSize };
+            m_native->headers[i].msg_hdr.msg_iov = &m_native->vectors[i];
+            m_native->headers[i].msg_hdr.msg_iovlen = 1;
+        }
+    }
+
+    DatagramSocket::Batch::~Batch() = default;
+    DatagramSocket::Batch::Batch(Batch&&) noexcept = default;
+    DatagramSocket::Batch& DatagramSocket::Batch::operator=(Batch&&) noexcept = default;
+
+    std::string_view DatagramSocket::Batch::data(size_t index) const {
+        auto& vector = m_native->vectors.at(index);
+        return std::string_view(static_cast<const char*>(vector.iov_base), vector.iov_len);
+    }
+
+    Socket::AddressIn DatagramSocket::Batch::address(size_t index) const {
+        return reinterpret_cast<const AddressIn&>(m_native->addresses.at(index));
+    }
+
+    size_t DatagramSocket::Batch::segmentSize(size_t index) const {
+        return m_native->segmentSizes.at(index);
+    }
+
+    bool DatagramSocket::Batch::push(std::string_view payload, const AddressIn* to) {
+        if (m_count == m_capacity || payload.size() > m_slotSize)
+            return false;
+
+        auto& vector = m_native->vectors[m_count];
+        std::copy(payload.begin(), payload.end(), static_cast<char*>(vector.iov_base));
+        vector.iov_len = payload.size();
+
+        auto& header = m_native->headers[m_count].msg_hdr;
+        if (to != nullptr) {
+            m_native->addresses[m_count] = reinterpret_cast<const sockaddr_in&>(*to);
+            header.msg_name = &m_native->addresses[m_count];
+            header.msg_namelen = sizeof(sockaddr_in);
+        }
+        else {
+            header.msg_name = nullptr;
+            header.msg_namelen = 0;
+        }
+        header.msg_control = nullptr;
+        header.msg_controllen = 0;
+        m_native->segmentSizes[m_count] = 0;
+        m_count++;
+        return true;
+    }
+
+    DatagramSocket::DatagramSocket(Domain domain /*= Domain::IPv4*/) :
+        Socket(domain, Type::Dgram, Protocol::UDP) {
+    }
+
+    Socket::AddressIn DatagramSocket::makeAddress(const char* ip, uint16_t port) {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        if (inet_pton(AF_INET, ip, &address.sin_addr) <= 0) {
+            throw std::runtime_error("Invalid IP address");
+        }
+        return reinterpret_cast<AddressIn&>(address);
+    }
+
+    size_t DatagramSocket::receiveBatch(Batch& batch) {
+        auto& native = *batch.m_native;
+        for (size_t i = 0; i < batch.m_capacity; i++) {
+            native.vectors[i].iov_len = batch.m_slotSize;
+            auto& header = native.headers[i].msg_hdr;
+            header.msg_name = &native.addresses[i];
+            header.msg_namelen = sizeof(sockaddr_in);
+            header.msg_control = native.control.data() + i * s_controlSize;
+            header.msg_controllen = s_controlSize;
+            header.msg_flags = 0;
+        }
+
+        int received = 0;
+        do {
+            received = ::recvmmsg(getHandle(), native.headers.data(), batch.m_capacity,
+                isNonBlocking() ? MSG_DONTWAIT : MSG_WAITFORONE, nullptr);
+        } while (received < 0 && getLastError() == Error::Interrupted);
+
+        if (received < 0) {
+            batch.m_count = 0;
+            if (getLastError() == Error::WouldBlock)
+                return 0;
+            throw std::runtime_error("Receive failed: " + getLastErrorString());
+        }
+
+        // lengths go into the vectors so a received batch can be sent back as is
+        for (int i = 0; i < received; i++) {
+            auto& header = native.headers[i].msg_hdr;
+            native.vectors[i].iov_len = native.headers[i].msg_len;
+            native.segmentSizes[i] = 0;
+            for (cmsghdr* entry = CMSG_FIRSTHDR(&header); entry != nullptr; entry = CMSG_NXTHDR(&header, entry)) {
+                if (entry->cmsg_level == SOL_UDP && entry->cmsg_type == UDP_GRO)
+                    native.segmentSizes[i] = *reinterpret_cast<int*>(CMSG_DATA(entry));
+            }
+            header.msg_control = nullptr;
+            header.msg_controllen = 0;
+        }
+        batch.m_count = received;
+        return received;
+    }
+
+    size_t DatagramSocket::sendBatch(Batch& batch, size_t first /*= 0*/) {
+        if (first >= batch.m_count)
+            return 0;
+
+        int sent = 0;
+        do {
+            sent = ::sendmmsg(getHandle(), batch.m_native->headers.data() + first,
+                batch.m_count - first, isNonBlocking() ? MSG_DONTWAIT : 0);
+        } while (sent < 0 && getLastError() == Error::Interrupted);
+
+        if (sent < 0) {
+            if (getLastError() == Error::WouldBlock)
+                return 0;
+            throw std::runtime_error("Send failed: " + getLastErrorString());
+        }
+        return sent;
+    }
+
+    // missing offloads show up as ENOPROTOOPT on older kernels
+    static bool setUdpOption(Socket::Handle handle, int option, int value, const char* name) {
+        if (setsockopt(handle, SOL_UDP, option, &value, sizeof(value)) == 0)
+            return true;
+        if (errno == ENOPROTOOPT || errno == EINVAL)
+            return false;
+        throw std::runtime_error(std::string("Failed to set ") + name + ": " +
+            Socket::getLastErrorString());
+    }
+
+    bool DatagramSocket::setSegmentSize(uint16_t segmentSize) {
+        return setUdpOption(getHandle(), UDP_SEGMENT, segmentSize, "UDP_SEGMENT");
+    }
+
+    bool DatagramSocket::setReceiveOffload(bool enable /*= true*/) {
+        return setUdpOption(getHandle(), UDP_GRO, enable ? 1 : 0, "UDP_GRO");
+    }
+
+    void DatagramSocket::asyncReceive(IOContext& context, Batch& batch, ReceiveHandler handler) {
+        if (!context.hasReactor()) {
+            context.post([this, &batch, handler = std::move(handler)]() {
+                try {
+                    // a non-blocking socket with nothing queued waits on poll instead of spinning on recvmmsg
+                    while (true) {
+                        if (receiveBatch(batch) == 0) {
+                            waitForData(s_idleWait);
+                            continue;
+                        }
+                        if (!handler(batch))
+                            break;
+                    }
+                }
+                catch (const std::exception& e) {
+                    std::cerr << "Datagram receive error: " << e.what() << std::endl;
+                }
+                });
+            return;
+        }
+
+        context.asyncWait(*this, Reactor::Event::Read,
+            [this, &context, &batch, handler = std::move(handler)](bool) mutable {
+                try {
+                    for (size_t i = 0; i < s_maxBatchesPerWakeup; i++) {
+                        if (receiveBatch(batch) == 0)
+                            break;
+                        if (!handler(batch))
+                            return;
+                    }
+                }
+                catch (const std::exception& e) {
+                    std::cerr << "Datagram receive error: " << e.what() << std::endl;
+                    return;
+                }
+                // datagrams left over make the new wait fire right away
+                asyncReceive(context, batch, std::move(handler));
+            });
+    }
+
+#endif
+}
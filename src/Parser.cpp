@@ -0,0 +1,345 @@
+#include "../include/Parser.h"
+
+#include "JsonParser/Utils/SIMDUtils.h"
+
+#include <charconv>
+
+namespace Network::HTTP
+{
+    namespace
+    {
+        // the next space separated token at or after position, position moves past it
+        bool nextToken(std::string_view line, size_t& position, std::string_view& token)
+        {
+            position = line.find_first_not_of(' ', position);
+            if (position == std::string_view::npos)
+                return false;
+
+            size_t end = std::min(line.find(' ', position), line.size());
+            token = line.substr(position, end - position);
+            position = end;
+            return true;
+        }
+
+        // header names are visible ascii without spaces (33 to 126), signed compares also catch bytes over 127
+        bool isValidName(std::string_view name)
+        {
+            size_t i = 0;
+#if defined(HAS_SSE2)
+            const __m128i low = _mm_set1_epi8(33);
+            const __m128i high = _mm_set1_epi8(126);
+            for (; i + 16 <= name.size(); i += 16)
+            {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(name.data() + i));
+                if (_mm_movemask_epi8(_mm_or_si128(_mm_cmplt_epi8(chunk, low), _mm_cmpgt_epi8(chunk, high))) != 0)
+                    return false;
+            }
+#endif
+            for (; i < name.size(); ++i)
+            {
+                if (name[i] <= 32 || name[i] >= 127)
+                    return false;
+            }
+            return true;
+        }
+
+        std::string_view trimWhitespace(std::string_view value)
+        {
+            size_t start = 0;
+            size_t end = value.size();
+            while (start < end && (value[start] == ' ' || value[start] == '\t'))
+                start++;
+            while (end > start && (value[end - 1] == ' ' || value[end - 1] == '\t'))
+                end--;
+            return value.substr(start, end - start);
+        }
+    }
+
+    size_t Parser::scanLine(std::string_view data, size_t from, size_t& colon)
+    {
+        size_t i = from;
+        const char* input = data.data();
+
+#if defined(HAS_AVX2)
+        const __m256i lineFeeds32 = _mm256_set1_epi8('\n');
+        const __m256i colons32 = _mm256_set1_epi8(':');
+        while (i + 32 <= data.size())
+        {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+            uint32_t lineMask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, lineFeeds32));
+            if (colon == std::string_view::npos)
+            {
+                // only colons in front of the line feed belong to this line
+                uint32_t colonMask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, colons32));
+                if (lineMask != 0)
+                    colonMask &= (lineMask & (0u - lineMask)) - 1;
+                if (colonMask != 0)
+                    colon = i + CTZ32(colonMask);
+            }
+            if (lineMask != 0)
+                return i + CTZ32(lineMask);
+            i += 32;
+        }
+#endif
+#if defined(HAS_SSE2)
+        // with AVX2 this only takes the last 16 to 31 bytes, small segments are common while a head trickles in
+        const __m128i lineFeeds16 = _mm_set1_epi8('\n');
+        const __m128i colons16 = _mm_set1_epi8(':');
+        while (i + 16 <= data.size())
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+            uint32_t lineMask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, lineFeeds16)));
+            if (colon == std::string_view::npos)
+            {
+                uint32_t colonMask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, colons16)));
+                if (lineMask != 0)
+                    colonMask &= (lineMask & (0u - lineMask)) - 1;
+                if (colonMask != 0)
+                    colon = i + CTZ32(colonMask);
+            }
+            if (lineMask != 0)
+                return i + CTZ32(lineMask);
+            i += 16;
+        }
+#endif
+
+        size_t lineFeed = data.find('\n', i);
+        if (colon == std::string_view::npos)
+            colon = data.substr(0, lineFeed).find(':', i);
+        return lineFeed;
+    }
+
+    bool Parser::parse(std::string_view data)
+    {
+        m_data = data;
+        while (m_state != State::Complete)
+        {
+            size_t lineFeed = scanLine(data, m_scanned, m_colon);
+            if (lineFeed == std::string_view::npos)
+            {
+                m_scanned = data.size();
+                if (data.size() > s_maxHeaderSize) {
+                    throw std::runtime_error("HTTP header too large (exceeds "
+                        + std::to_string(s_maxHeaderSize / 1024) + "KB limit, received: "
+                        + std::to_string(data.size() / 1024) + "KB)");
+                }
+                return false;
+            }
+
+            if (lineFeed >= s_maxHeaderSize) {
+                throw std::runtime_error("HTTP header too large (exceeds "
+                    + std::to_string(s_maxHeaderSize / 1024) + "KB limit)");
+            }
+
+            size_t lineEnd = lineFeed;
+            if (lineEnd > m_lineStart && data[lineEnd - 1] == '\r')
+                lineEnd--;
+            auto line = data.substr(m_lineStart, lineEnd - m_lineStart);
+
+            if (m_state == State::FirstLine)
+            {
+                // empty lines before the first one are skipped, a client may send one after a body
+                if (!line.empty())
+                {
+                    parseFirstLine(line);
+                    m_state = State::Headers;
+                }
+            }
+            else if (line.empty())
+                m_state = State::Complete;
+            else
+                parseHeaderLine(line, m_colon == std::string_view::npos ? m_colon : m_colon - m_lineStart);
+
+            m_lineStart = m_scanned = lineFeed + 1;
+            m_colon = std::string_view::npos;
+        }
+        return true;
+    }
+
+    void Parser::parseFirstLine(std::string_view line)
+    {
+        size_t position = 0;
+        std::string_view token;
+        nextToken(line, position, token);
+
+        if (token.starts_with("HTTP/")) // message is a response
+        {
+            if (!token.starts_with("HTTP/1.") || token.length() != 8)
+                throw std::runtime_error("Invalid HTTP version: " + std::string(token));
+
+            std::string_view version = token;
+            if (!nextToken(line, position, token))
+                throw std::runtime_error("Missing status code");
+
+            int code = 0;
+            auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), code);
+            auto statusCode = static_cast<Response::StatusCode>(code);
+            if (error != std::errc() || end != token.data() + token.size() || token.size() != 3
+                || !Response::s_statusCodeToStringMap.contains(statusCode))
+                throw std::runtime_error("Unknown status code: " + std::string(token) + "\n");
+
+            // the status message runs to the end of the line and may contain spaces
+            auto statusMessage = trimWhitespace(line.substr(position));
+            if (statusMessage.empty())
+                throw std::runtime_error("Missing status message");
+
+            m_isRequest = false;
+            m_statusCode = statusCode;
+            m_version = sliceOf(version);
+            m_target = sliceOf(statusMessage);
+        }
+        else // message is a request
+        {
+            auto method = Request::stringToMethod(token);
+            if (method == Request::Method::Unknown)
+                throw std::runtime_error("Unknown request method: " + std::string(token) + "\n");
+
+            std::string_view uri;
+            if (!nextToken(line, position, uri))
+                throw std::runtime_error("Missing URI");
+
+            if (!nextToken(line, position, token))
+                throw std::runtime_error("Missing HTTP version");
+            if (!token.starts_with("HTTP/1.") || token.length() != 8)
+                throw std::runtime_error("Invalid HTTP version: " + std::string(token));
+
+            m_isRequest = true;
+            m_method = method;
+            m_target = sliceOf(uri);
+            m_version = sliceOf(token);
+        }
+    }
+
+    void Parser::parseHeaderLine(std::string_view line, size_t colonPos)
+    {
+        // a line starting with whitespace continues the previous value (obsolete line folding),
+        // the value slice simply grows over it and unfold() joins the lines once it is needed
+        if (line.front() == ' ' || line.front() == '\t')
+        {
+            if (m_headers.empty())
+                throw std::runtime_error("Invalid header line (folded first header): " + std::string(line));
+
+            auto continuation = trimWhitespace(line);
+            if (continuation.empty())
+                return;
+
+            auto& header = m_headers.back();
+            header.value.length = static_cast<uint32_t>(continuation.data() + continuation.size() - m_data.data()) - header.value.offset;
+            header.folded = true;
+            if (header.value.length > s_maxHeaderValueLength)
+                throw std::runtime_error("Header value too long after folding: " + std::string(view(header.name)));
+            return;
+        }
+
+        if (colonPos == std::string_view::npos)
+            throw std::runtime_error("Invalid header line (no colon): " + std::string(line));
+
+        auto name = line.substr(0, colonPos);
+        auto value = trimWhitespace(line.substr(colonPos + 1));
+
+        if (name.empty() || value.empty())
+            throw std::runtime_error("Invalid header: " + std::string(name) + ":" + std::string(value));
+
+        if (name.length() > s_maxHeaderNameLength)
+            throw std::runtime_error("Header name too long: " + std::string(name));
+        if (value.length() > s_maxHeaderValueLength)
+            throw std::runtime_error("Header value too long: " + std::string(value));
+
+        // no control chars, spaces, or colons
+        if (!isValidName(name))
+            throw std::runtime_error("Invalid character in header name: " + std::string(name));
+
+        m_headers.push_back(HeaderSlices{ sliceOf(name), sliceOf(value), false });
+    }
+
+    void Parser::reset()
+    {
+        m_state = State::FirstLine;
+        m_data = {};
+        m_lineStart = 0;
+        m_scanned = 0;
+        m_colon = std::string_view::npos;
+        m_isRequest = true;
+        m_method = Request::Method::Unknown;
+        m_statusCode = Response::StatusCode::Unknown;
+        m_target = {};
+        m_version = {};
+        m_headers.clear();
+    }
+
+    std::string_view Parser::findHeader(std::string_view name) const
+    {
+        Detail::CaseInsensitiveStringComparator equal;
+        for (auto& header : m_headers)
+        {
+            if (equal(view(header.name), name))
+                return view(header.value);
+        }
+        return {};
+    }
+
+    std::string Parser::unfold(std::string_view value)
+    {
+        std::string unfolded;
+        unfolded.reserve(value.size());
+        for (size_t i = 0; i < value.size(); i++)
+        {
+            if (value[i] != '\r' && value[i] != '\n')
+            {
+                unfolded += value[i];
+                continue;
+            }
+
+            while (!unfolded.empty() && (unfolded.back() == ' ' || unfolded.back() == '\t'))
+                unfolded.pop_back();
+            while (i + 1 < value.size() && std::string_view("\r\n \t").find(value[i + 1]) != std::string_view::npos)
+                i++;
+            unfolded += ' ';
+        }
+        return unfolded;
+    }
+
+    std::unique_ptr<Message> Parser::toMessage() const
+    {
+        if (m_state != State::Complete)
+            throw std::runtime_error("HTTP head is incomplete");
+
+        std::unique_ptr<Message> message;
+        if (m_isRequest)
+        {
+            auto request = std::make_unique<Request>();
+            request->setMethod(m_method);
+            request->setUri(view(m_target));
+            message = std::move(request);
+        }
+        else
+        {
+            auto response = std::make_unique<Response>();
+            response->setStatusCode(m_statusCode);
+            response->setStatusMessage(view(m_target));
+            message = std::move(response);
+        }
+        message->setVersion(view(m_version));
+
+        // the head is copied once and the headers reference it, only unfolded values need room of their own
+        size_t foldedSize = 0;
+        for (auto& header : m_headers)
+        {
+            if (header.folded)
+                foldedSize += header.value.length;
+        }
+
+        auto& headers = message->getHeaders();
+        headers.storeHead(m_data.substr(0, m_lineStart), foldedSize);
+        for (auto& header : m_headers)
+        {
+            auto head = headers.getStoredHead();
+            auto name = head.substr(header.name.offset, header.name.length);
+            if (header.folded)
+                headers.set(name, unfold(view(header.value)));
+            else
+                headers.set(name, head.substr(header.value.offset, header.value.length));
+        }
+        return message;
+    }
+}
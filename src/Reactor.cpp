@@ -0,0 +1,284 @@
+#include "../include/Reactor.h"
+
+#ifndef _WIN32
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#ifdef _WIN32
+
+// epoll is linux only, windows builds keep using the blocking backend
+Reactor::Reactor(WorkStealingPool& pool) : m_pool(pool) {
+    throw std::runtime_error("Reactor backend is not supported on this platform");
+}
+
+Reactor::~Reactor() {}
+void Reactor::start() {}
+void Reactor::stop() {}
+void Reactor::loop() {}
+void Reactor::wake() {}
+void Reactor::rearm(Network::Socket::Handle handle, Registration& registration) {}
+void Reactor::expireDeadlines(std::vector<std::function<void()>>& ready) {}
+int Reactor::nextTimeout() { return -1; }
+void Reactor::asyncWait(Network::Socket::Handle handle, Event event, WaitCallback callback) {}
+void Reactor::asyncWait(Network::Socket::Handle handle, Event event,
+    Clock::time_point deadline, WaitCallback callback) {}
+void Reactor::cancel(Network::Socket::Handle handle) {}
+
+#else
+
+Reactor::Reactor(WorkStealingPool& pool) : m_pool(pool)
+{
+    m_pollHandle = epoll_create1(EPOLL_CLOEXEC);
+    if (m_pollHandle < 0) {
+        throw std::runtime_error("Failed to create epoll instance: " +
+            Network::Socket::getLastErrorString());
+    }
+
+    m_wakeHandle = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeHandle < 0) {
+        ::close(m_pollHandle);
+        throw std::runtime_error("Failed to create wakeup handle: " +
+            Network::Socket::getLastErrorString());
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = m_wakeHandle;
+    if (epoll_ctl(m_pollHandle, EPOLL_CTL_ADD, m_wakeHandle, &event) < 0) {
+        ::close(m_wakeHandle);
+        ::close(m_pollHandle);
+        throw std::runtime_error("Failed to register wakeup handle: " +
+            Network::Socket::getLastErrorString());
+    }
+}
+
+Reactor::~Reactor()
+{
+    stop();
+    ::close(m_wakeHandle);
+    ::close(m_pollHandle);
+}
+
+void Reactor::start()
+{
+    if (m_shouldRun.exchange(true))
+        return;
+    m_thread = std::thread(&Reactor::loop, this);
+}
+
+void Reactor::stop()
+{
+    if (!m_shouldRun.exchange(false))
+        return;
+    wake();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void Reactor::wake()
+{
+    uint64_t one = 1;
+    [[maybe_unused]] auto result = ::write(m_wakeHandle, &one, sizeof(one));
+}
+
+void Reactor::asyncWait(Network::Socket::Handle handle, Event event, WaitCallback callback)
+{
+    asyncWait(handle, event, Clock::time_point::max(), std::move(callback));
+}
+
+void Reactor::asyncWait(Network::Socket::Handle handle, Event event,
+    Clock::time_point deadline, WaitCallback callback)
+{
+    if (handle < 0)
+        throw std::runtime_error("Cannot wait on a closed socket");
+
+    bool shouldWake = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (static_cast<size_t>(handle) >= m_registrations.size())
+            m_registrations.resize(std::max<size_t>(handle + 1, m_registrations.size() * 2));
+
+        auto& registration = m_registrations[handle];
+        auto& waiter = event == Event::Read ? registration.read : registration.write;
+        waiter.callback = std::move(callback);
+        waiter.generation++;
+
+        if (deadline != Clock::time_point::max()) {
+            shouldWake = m_deadlines.empty() || deadline < m_deadlines.top().time;
+            m_deadlines.push(Deadline{ deadline, handle, event, waiter.generation });
+        }
+
+        rearm(handle, registration);
+    }
+
+    if (shouldWake)
+        wake();
+}
+
+void Reactor::cancel(Network::Socket::Handle handle)
+{
+    WaitCallback readCallback;
+    WaitCallback writeCallback;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (handle < 0 || static_cast<size_t>(handle) >= m_registrations.size())
+            return;
+
+        auto& registration = m_registrations[handle];
+        if (registration.added)
+            epoll_ctl(m_pollHandle, EPOLL_CTL_DEL, handle, nullptr);
+        registration.added = false;
+
+        // bumping the generation invalidates any deadline still in the queue
+        readCallback = std::move(registration.read.callback);
+        registration.read.callback = nullptr;
+        registration.read.generation++;
+        writeCallback = std::move(registration.write.callback);
+        registration.write.callback = nullptr;
+        registration.write.generation++;
+    }
+    // callbacks are destroyed outside the lock, they may own the session that owns the socket
+}
+
+void Reactor::rearm(Network::Socket::Handle handle, Registration& registration)
+{
+    epoll_event event{};
+    event.events = EPOLLET | EPOLLONESHOT;
+    if (registration.read.callback)
+        event.events |= EPOLLIN | EPOLLRDHUP;
+    if (registration.write.callback)
+        event.events |= EPOLLOUT;
+    event.data.fd = handle;
+
+    if (!registration.added) {
+        if (epoll_ctl(m_pollHandle, EPOLL_CTL_ADD, handle, &event) == 0) {
+            registration.added = true;
+            return;
+        }
+        if (errno != EEXIST)
+            throw std::runtime_error("Failed to register socket with the reactor: " +
+                Network::Socket::getLastErrorString());
+    }
+
+    // the kernel forgets closed handles on its own, so a reused handle may need adding again
+    if (epoll_ctl(m_pollHandle, EPOLL_CTL_MOD, handle, &event) < 0) {
+        if (errno != ENOENT || epoll_ctl(m_pollHandle, EPOLL_CTL_ADD, handle, &event) < 0)
+            throw std::runtime_error("Failed to rearm socket in the reactor: " +
+                Network::Socket::getLastErrorString());
+    }
+    registration.added = true;
+}
+
+int Reactor::nextTimeout()
+{
+    if (m_deadlines.empty())
+        return -1;
+
+    auto now = Clock::now();
+    auto top = m_deadlines.top().time;
+    if (top <= now)
+        return 0;
+
+    auto milliseconds = std::chrono::ceil<std::chrono::milliseconds>(top - now).count();
+    return static_cast<int>(std::min<int64_t>(milliseconds, std::numeric_limits<int>::max()));
+}
+
+void Reactor::expireDeadlines(std::vector<std::function<void()>>& ready)
+{
+    auto now = Clock::now();
+    while (!m_deadlines.empty() && m_deadlines.top().time <= now)
+    {
+        auto deadline = m_deadlines.top();
+        m_deadlines.pop();
+
+        if (static_cast<size_t>(deadline.handle) >= m_registrations.size())
+            continue;
+
+        auto& registration = m_registrations[deadline.handle];
+        auto& waiter = deadline.event == Event::Read ? registration.read : registration.write;
+        if (waiter.generation != deadline.generation || !waiter.callback)
+            continue; //already fired or replaced by a newer wait
+
+        ready.push_back([callback = std::move(waiter.callback)]() { callback(false); });
+        waiter.callback = nullptr;
+        if (registration.added)
+            rearm(deadline.handle, registration);
+    }
+}
+
+void Reactor::loop()
+{
+    std::array<epoll_event, s_maxEventsPerWait> events;
+    std::vector<std::function<void()>> ready;
+
+    while (m_shouldRun.load())
+    {
+        int timeout;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            timeout = nextTimeout();
+        }
+
+        int count = epoll_wait(m_pollHandle, events.data(), static_cast<int>(events.size()), timeout);
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            std::cerr << "Reactor wait failed: " << Network::Socket::getLastErrorString() << std::endl;
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (int i = 0; i < count; i++)
+            {
+                auto handle = events[i].data.fd;
+                if (handle == m_wakeHandle) {
+                    uint64_t value;
+                    while (::read(m_wakeHandle, &value, sizeof(value)) > 0);
+                    continue;
+                }
+
+                if (static_cast<size_t>(handle) >= m_registrations.size())
+                    continue;
+
+                auto& registration = m_registrations[handle];
+                auto flags = events[i].events;
+                bool failed = flags & (EPOLLHUP | EPOLLERR);
+
+                // hangups and errors are reported as ready, the following read or write surfaces them
+                if ((failed || flags & (EPOLLIN | EPOLLRDHUP)) && registration.read.callback) {
+                    ready.push_back([callback = std::move(registration.read.callback)]() { callback(true); });
+                    registration.read.callback = nullptr;
+                }
+                if ((failed || flags & EPOLLOUT) && registration.write.callback) {
+                    ready.push_back([callback = std::move(registration.write.callback)]() { callback(true); });
+                    registration.write.callback = nullptr;
+                }
+
+                try {
+                    if (registration.read.callback || registration.write.callback)
+                        rearm(handle, registration);
+                }
+                catch (const std::exception& e) {
+                    std::cerr << e.what() << std::endl;
+                }
+            }
+
+            try {
+                expireDeadlines(ready);
+            }
+            catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+            }
+        }
+
+        for (auto& task : ready)
+            m_pool.pushTask(std::move(task));
+        ready.clear();
+    }
+}
+
+#endif
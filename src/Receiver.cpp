@@ -3,157 +3,6 @@
 namespace Network::HTTP
 {
 
-    void Receiver::parseFirstLine(std::stringstream& line, std::unique_ptr<Message>& message)
-    {
-        std::string token;
-
-        if (!(line >> token)) {
-            throw std::runtime_error("Invalid HTTP message: empty first line");
-        }
-
-        if (token.starts_with("HTTP/")) // message is a response
-        {
-            message = std::make_unique<Response>();
-            auto* response = static_cast<Response*>(&(*message));
-
-            // Validate and set version
-            if (!token.starts_with("HTTP/1.") || token.length() != 8) {
-                throw std::runtime_error("Invalid HTTP version: " + token);
-            }
-            response->setVersion(token);
-
-            // Parse status code
-            if (!(line >> token)) {
-                throw std::runtime_error("Missing status code");
-            }
-            
-            auto statusCode = Response::stringToStatusCode(token);
-            if (statusCode == Response::StatusCode::Unknown)
-                throw std::runtime_error("Unknown status code: " + token + "\n");
-            response->setStatusCode(statusCode);
-
-            // Get rest of line as status message (might contain spaces)
-            std::string statusMsg;
-            std::getline(line, statusMsg, '\n');
-            if (!statusMsg.empty()) {
-                if (statusMsg[0] == ' ') {
-                    statusMsg = statusMsg.substr(1); // Remove leading space
-                }
-                // Remove trailing \r if present
-                if (statusMsg.back() == '\r') {
-                    statusMsg.pop_back();
-                }
-            }
-            if (statusMsg.empty()) {
-                throw std::runtime_error("Missing status message");
-            }
-            response->setStatusMessage(statusMsg);
-        }
-        else // message is a request
-        {
-            message = std::make_unique<Request>();
-            auto* request = static_cast<Request*>(&(*message));
-
-            // Set method
-            auto method = Request::stringToMethod(token);
-            if (method == Request::Method::Unknown)
-                throw std::runtime_error("Unknown request method: " + token + "\n");
-            request->setMethod(method);
-
-            // Parse URI
-            if (!(line >> token)) {
-                throw std::runtime_error("Missing URI");
-            }
-            request->setUri(token);
-
-            // Parse version
-            if (!(line >> token)) {
-                throw std::runtime_error("Missing HTTP version");
-            }
-            if (!token.starts_with("HTTP/1.") || token.length() != 8) {
-                throw std::runtime_error("Invalid HTTP version: " + token);
-            }
-            request->setVersion(token);
-            std::getline(line, token, '\n'); //remove end of line
-        }
-    }
-
-    bool Receiver::parseHeaders(std::stringstream& headers, std::unique_ptr<Message>& message)
-    {
-        std::string header;
-        std::string line;
-        std::string value;
-        auto& msgHeaders = message->getHeaders();
-
-        while (headers.good() && !headers.eof())
-        {
-            // Read the next line
-            std::getline(headers, line, '\n');
-
-            // Check for empty line (marks end of headers)
-            if (line == "\r" || line.empty())
-                return true;
-
-            // Find the colon
-            size_t colonPos = line.find(':');
-            if (colonPos == std::string::npos)
-                throw std::runtime_error("Invalid header line (no colon): " + line);
-
-            // Split into header and value
-            header = line.substr(0, colonPos);
-            value = line.substr(colonPos + 1);
-
-            // Trim whitespace
-            while (!value.empty() && (value[0] == ' ' || value[0] == '\t'))
-                value.erase(0, 1);
-
-            // Remove trailing \r if present
-            if (!value.empty() && value.back() == '\r')
-                value.pop_back();
-
-            // Validate header name and value
-            if (header.empty() || value.empty())
-                throw std::runtime_error("Invalid header: " + header + ":" + value);
-
-            if (header.length() > s_maxHeaderNameLength)
-                throw std::runtime_error("Header name too long: " + header);
-            if (value.length() > s_maxHeaderValueLength)
-                throw std::runtime_error("Header value too long: " + value);
-
-            // Check header name doesn't contain invalid characters
-            for (char c : header)
-            {
-                if (c <= 32 || c >= 127 || c == ':')  // No control chars, spaces, or colons
-                    throw std::runtime_error("Invalid character in header name: " + header);
-            }
-
-            // Handle folded headers
-            while (headers.good() && !headers.eof())
-            {
-                char next = headers.peek();
-                if (next != ' ' && next != '\t')
-                    break;
-
-                // This is a folded header line
-                std::string continuation;
-                std::getline(headers, continuation, '\n');
-                if (!continuation.empty() && continuation.back() == '\r')
-                    continuation.pop_back();
-                // Remove leading whitespace
-                continuation.erase(0, continuation.find_first_not_of(" \t"));
-                // Append to previous value with a space
-                value += ' ' + continuation;
-
-                if (value.length() > s_maxHeaderValueLength)
-                    throw std::runtime_error("Header value too long after folding: " + header);
-            }
-
-            msgHeaders.set(header, value);
-        }
-
-        return false; // No empty line found - incomplete headers
-    }
-
     std::pair<Message::TransferMethod, int> Receiver::determineTransferMethod(std::unique_ptr<Message>& message)
     {
         auto value = message->getHeaders().get(Message::Headers::Standard::TransferEncoding);
@@ -164,18 +13,18 @@ namespace Network::HTTP
             }
 
             // Other transfer encodings are not supported in HTTP/1.1
-            throw std::runtime_error("Unsupported Transfer-Encoding: " + value);
+            throw std::runtime_error("Unsupported Transfer-Encoding: " + std::string(value));
         }
         value = message->getHeaders().get(Message::Headers::Standard::ContentLength);
 
         if (!value.empty() && value != "0") {
             try {
-                size_t length = std::stoull(value);
+                size_t length = std::stoull(std::string(value));
                 return std::make_pair<Message::TransferMethod, int>
                     (Message::TransferMethod::ContentLength, length);
             }
             catch (const std::exception&) {
-                throw std::runtime_error("Invalid Content-Length: " + value);
+                throw std::runtime_error("Invalid Content-Length: " + std::string(value));
             }
         }
 
@@ -185,24 +34,26 @@ namespace Network::HTTP
 
     size_t Receiver::readHeader(Socket& sock, Buffer& leftovers, std::unique_ptr<Message>& message)
     {
-        leftovers.resize(1024);
+        size_t carried = leftovers.size();
         size_t bytesReadTotal = 0;
+        Parser parser;
 
         try
         {
-            sock.receiveLoop(leftovers.data(),
-                leftovers.size(), 0, s_maxRetryCount,
-                [&leftovers, &message, &bytesReadTotal]
-                (char*& buffer, size_t& len, size_t bytesRead, size_t& receivedTotal) {
+            // a pipelined request may already be complete in what the previous one left behind
+            if (parser.parse(leftovers)) {
+                finishHeader(parser, leftovers, carried, message);
+                return 0;
+            }
 
-                    if (receivedTotal > s_maxHeaderSize) {
-                        throw std::runtime_error("HTTP header too large (exceeds "
-                            + std::to_string(s_maxHeaderSize / 1024) + "KB limit, received: "
-                            + std::to_string(receivedTotal / 1024) + "KB)");
-                    }
+            leftovers.resize(std::max<size_t>(carried * 2, 1024));
+            size_t receivedTotal = sock.receiveLoop(leftovers.data() + carried,
+                leftovers.size() - carried, carried, s_maxRetryCount,
+                [&leftovers, &message, &bytesReadTotal, &parser, carried]
+                (char*& buffer, size_t& len, size_t bytesRead, size_t& receivedTotal) {
 
-                    auto headerEnd = leftovers.find("\r\n\r\n");
-                    if (headerEnd == std::string::npos) {
+                    // picks up at the line the previous receive ended in
+                    if (!parser.parse(std::string_view(leftovers.data(), receivedTotal))) {
 
                         if (leftovers.size() - receivedTotal < leftovers.size() / 4)
                             leftovers.resize(leftovers.size() * 2);
@@ -211,25 +62,52 @@ namespace Network::HTTP
                         return true;
                     }
 
-                    bytesReadTotal = receivedTotal;
-                    std::stringstream ss(leftovers.substr(0, headerEnd + 4));
-                    leftovers.erase(0, headerEnd + 4);
-                    leftovers.resize(bytesReadTotal - headerEnd - 4);
-
-                    parseFirstLine(ss, message);
-                    parseHeaders(ss, message);
+                    finishHeader(parser, leftovers, receivedTotal, message);
+                    bytesReadTotal = receivedTotal - carried;
                     return false;
                 }
             );
+
+            // closed or timed out halfway through a head, only what really arrived stays
+            if (message == nullptr)
+                leftovers.resize(receivedTotal);
         }
         catch (const std::exception& e)
         {
             std::cerr << "Error parsing message: " << e.what() << std::endl;
+            message.reset();
             return 0;
         }
         return bytesReadTotal;
     }
 
+    void Receiver::finishHeader(Parser& parser, Buffer& leftovers, size_t receivedTotal,
+        std::unique_ptr<Message>& message)
+    {
+        message = parser.toMessage();
+        leftovers.resize(receivedTotal);
+        leftovers.erase(0, parser.getHeadSize());
+    }
+
+    size_t Receiver::readBody(Socket& sock, Buffer& leftovers,
+        std::unique_ptr<Message>& message, BodyTypeHandler handler)
+    {
+        auto methodAndLength = determineTransferMethod(message);
+        message->setBody(handler(message));
+
+        switch (methodAndLength.first)
+        {
+        case Message::TransferMethod::ContentLength:
+            return message->getBody()->readTransferSize
+            (sock, leftovers, methodAndLength.second, s_maxRetryCount, s_maxBodySize);
+        case Message::TransferMethod::Chunked:
+            return message->getBody()->readChunked
+            (sock, leftovers, s_maxRetryCount, s_maxBodySize);
+        default:
+            return 0; //HTTP/1.1 only supports chunked or content length transfer methods
+        }
+    }
+
     size_t Receiver::read(Socket& sock, std::unique_ptr<Message>& message)
     {
         std::string leftovers;
@@ -252,37 +130,29 @@ namespace Network::HTTP
 
     size_t Receiver::read(Socket& sock, std::unique_ptr<Message>& message, BodyTypeHandler handler)
     {
-        std::string leftovers;
+        Buffer leftovers;
+        return read(sock, leftovers, message, std::move(handler));
+    }
+
+    size_t Receiver::read(Socket& sock, Buffer& leftovers, std::unique_ptr<Message>& message, BodyTypeHandler handler)
+    {
         size_t bytesRead = 0;
 
         try
         {
             bytesRead += readHeader(sock, leftovers, message);
             if (message == nullptr)
-                return 0;
-
-            auto methodAndLength = determineTransferMethod(message);
-            message->setBody(handler(message));
-
-            switch (methodAndLength.first)
-            {
-            case Message::TransferMethod::ContentLength:
-                bytesRead += message->getBody()->readTransferSize
-                (sock, leftovers, methodAndLength.second, s_maxRetryCount, s_maxBodySize);
-                break;
-            case Message::TransferMethod::Chunked:
-                bytesRead += message->getBody()->readChunked
-                (sock, leftovers, s_maxRetryCount, s_maxBodySize);
-                break;
-            default:
-                break; //HTTP/1.1 only supports chunked or content length transfer methods
-            }
+                return bytesRead;
 
+            bytesRead += readBody(sock, leftovers, message, handler);
             return bytesRead;
         }
         catch (std::exception& e)
         {
             std::cerr << "Error parsing message: " << e.what() << std::endl;
+            message.reset(); //never hand out a request with half a body
+            leftovers.clear();
+            return bytesRead;
         }
     }
 
@@ -292,7 +162,7 @@ namespace Network::HTTP
     {
         try
         {
-            context.post([&context, &sock, &message, callback]() {
+            context.postWhenReady(sock, Reactor::Event::Read, [&context, &sock, &message, callback]() {
                 try
                 {
                     size_t bytesRead = 0;
@@ -321,7 +191,7 @@ namespace Network::HTTP
     {
         try
         {
-            context.post([&context, &sock, &message, handler, callback]() {
+            context.postWhenReady(sock, Reactor::Event::Read, [&context, &sock, &message, handler, callback]() {
                 size_t bytesRead = 0;
                 Buffer leftovers;
                 std::unique_ptr<Message> message;
@@ -364,9 +234,17 @@ namespace Network::HTTP
         Buffer& leftovers, std::unique_ptr<Message>& message,
         std::function<void(size_t)> callback)
     {
+        if (context.hasUring())
+        {
+            uringReadHeader(context, sock, leftovers, message, [&context, callback](size_t bytesRead) {
+                context.postParserCallback(bytesRead, callback);
+                });
+            return;
+        }
+
         try
         {
-            context.post([&context, &sock, callback, &leftovers, &message]() {
+            context.postWhenReady(sock, Reactor::Event::Read, [&context, &sock, callback, &leftovers, &message]() {
                 try
                 {
                     size_t bytesRead = 0;
@@ -384,4 +262,173 @@ namespace Network::HTTP
             throw std::runtime_error("Error during asynchronous header reading: " + std::string(e.what()));
         }
     }
+
+    Task<size_t> Receiver::receiveMore(IOContext& context, Socket& sock, Buffer& leftovers)
+    {
+        size_t used = leftovers.size();
+        leftovers.resize(used + s_receiveChunkSize);
+
+        size_t bytesRead = 0;
+        try
+        {
+            bytesRead = co_await sock.asyncRead(context, leftovers.data() + used, s_receiveChunkSize);
+        }
+        catch (const std::exception&)
+        {
+            leftovers.resize(used);
+            throw;
+        }
+        leftovers.resize(used + bytesRead);
+        co_return bytesRead;
+    }
+
+    Task<void> Receiver::receiveAtLeast(IOContext& context, Socket& sock, Buffer& leftovers,
+        size_t size, size_t& received)
+    {
+        while (leftovers.size() < size)
+        {
+            auto bytesRead = co_await receiveMore(context, sock, leftovers);
+            if (bytesRead == 0)
+                throw std::runtime_error("Connection closed in the middle of a message");
+            received += bytesRead;
+        }
+    }
+
+    Task<size_t> Receiver::asyncReadHeader(IOContext& context, Socket& sock,
+        Buffer& leftovers, std::unique_ptr<Message>& message)
+    {
+        size_t received = 0;
+        Parser parser;
+        while (!parser.parse(leftovers))
+        {
+            auto bytesRead = co_await receiveMore(context, sock, leftovers);
+            if (bytesRead == 0)
+                co_return received;
+            received += bytesRead;
+        }
+
+        finishHeader(parser, leftovers, leftovers.size(), message);
+        co_return received;
+    }
+
+    Task<size_t> Receiver::asyncReadBody(IOContext& context, Socket& sock,
+        Buffer& leftovers, std::unique_ptr<Message>& message, BodyTypeHandler handler)
+    {
+        auto methodAndLength = determineTransferMethod(message);
+        message->setBody(handler(message));
+        auto& body = *message->getBody();
+        size_t received = 0;
+
+        switch (methodAndLength.first)
+        {
+        case Message::TransferMethod::ContentLength:
+        {
+            size_t length = methodAndLength.second;
+            if (length > s_maxBodySize) {
+                throw std::runtime_error("Content size exceeds maximum allowed ("
+                    + std::to_string(length / 1024) + "KB > "
+                    + std::to_string(s_maxBodySize / 1024) + "KB)");
+            }
+
+            // large bodies go through in pieces so leftovers never holds more than a chunk of them
+            while (true)
+            {
+                size_t part = std::min(length, leftovers.size());
+                body.append(leftovers.data(), part);
+                leftovers.erase(0, part);
+                length -= part;
+                if (length == 0)
+                    break;
+                co_await receiveAtLeast(context, sock, leftovers, 1, received);
+            }
+            break;
+        }
+        case Message::TransferMethod::Chunked:
+        {
+            ChunkedDecoder decoder(s_maxBodySize);
+            while (true)
+            {
+                leftovers.erase(0, decoder.decode(leftovers, body));
+                if (decoder.isComplete())
+                    break;
+
+                auto bytesRead = co_await receiveMore(context, sock, leftovers);
+                if (bytesRead == 0)
+                    throw std::runtime_error("Connection closed in the middle of a message");
+                received += bytesRead;
+            }
+            break;
+        }
+        default:
+            break; //HTTP/1.1 only supports chunked or content length transfer methods
+        }
+
+        co_return received;
+    }
+
+    Task<size_t> Receiver::asyncRead(IOContext& context, Socket& sock,
+        Buffer& leftovers, std::unique_ptr<Message>& message, BodyTypeHandler handler)
+    {
+        size_t bytesRead = co_await asyncReadHeader(context, sock, leftovers, message);
+        if (message == nullptr)
+            co_return bytesRead;
+
+        bytesRead += co_await asyncReadBody(context, sock, leftovers, message, std::move(handler));
+        co_return bytesRead;
+    }
+
+    void Receiver::uringReadHeader(IOContext& context, Socket& sock,
+        Buffer& leftovers, std::unique_ptr<Message>& message,
+        std::function<void(size_t)> callback)
+    {
+        auto parser = std::make_shared<Parser>();
+        try
+        {
+            // a pipelined request may already be complete in what the previous one left behind,
+            // parsed from buffered bytes alone it took nothing off the socket
+            if (parser->parse(leftovers)) {
+                finishHeader(*parser, leftovers, leftovers.size(), message);
+                callback(0);
+                return;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error parsing message: " << e.what() << std::endl;
+            callback(0);
+            return;
+        }
+
+        auto received = std::make_shared<size_t>(0);
+        context.getUring().asyncReceive(sock.getHandle(),
+            [&leftovers, parser, received](const char* data, size_t length) {
+                if (data == nullptr)
+                    return false;
+
+                // bytes past the header are kept, the body reader picks them up from leftovers
+                leftovers.append(data, length);
+                *received += length;
+                try
+                {
+                    return !parser->parse(leftovers);
+                }
+                catch (const std::exception&)
+                {
+                    return false; //the completion parses again and reports it
+                }
+            },
+            [&leftovers, &message, parser, received, callback]() {
+                size_t bytesRead = *received;
+                try
+                {
+                    if (parser->parse(leftovers))
+                        finishHeader(*parser, leftovers, leftovers.size(), message);
+                }
+                catch (const std::exception& e)
+                {
+                    std::cerr << "Error parsing message: " << e.what() << std::endl;
+                }
+                callback(bytesRead);
+            });
+    }
 }
\ No newline at end of file
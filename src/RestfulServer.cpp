@@ -40,6 +40,18 @@ namespace Network::HTTP
 		return resp;
 	}
 
+	Task<std::unique_ptr<Response>> RestfulServer::handleAsync(Request& req, Request::Method method) {
+		std::vector<std::string_view> params;
+		auto node = findNode(m_root, req.getUri(), params);
+		if (node == nullptr || node->asyncHandlers[static_cast<size_t>(method)] == nullptr)
+			co_return m_core.handleRequest(req);
+
+		auto resp = co_await node->asyncHandlers[static_cast<size_t>(method)](req, params);
+		addCORSHeaders(*resp);
+		addSuccessfulHeaders(*resp);
+		co_return resp;
+	}
+
 	std::unique_ptr<Response> RestfulServer::handleGet(Request& req) {
 		return handleGeneric(req, Request::Method::Get, &RestfulServer::createNotFoundResponse);
 	}
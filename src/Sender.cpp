@@ -3,13 +3,17 @@
 namespace Network::HTTP
 {
 
-	size_t Sender::sendHeaders(Socket& sock, std::unique_ptr<Message>& message)
+	std::string Sender::serializeHeaders(std::unique_ptr<Message>& message)
 	{
 		std::string headers = message->getFirstLine();
-		for (const auto& [header, value] : message->getHeaders()) {
-			headers += header + ": " + value + "\r\n";
-		}
+		message->getHeaders().serialize(headers);
 		headers += "\r\n";
+		return headers;
+	}
+
+	size_t Sender::sendHeaders(Socket& sock, std::unique_ptr<Message>& message)
+	{
+		std::string headers = serializeHeaders(message);
 		return sock.sendCommited(headers.data(), headers.size(), s_maxRetryCount);
 	}
 
@@ -21,21 +25,125 @@ namespace Network::HTTP
 			auto& headers = message->getHeaders();
 			auto size = headers.get(Message::Headers::Standard::ContentLength);
 			if (size != "")
-				return body->sendTransferSize(sock, std::stoi(size), s_maxRetryCount, s_maxBodySize);
+				return body->sendTransferSize(sock, std::stoi(std::string(size)), s_maxRetryCount, s_maxBodySize);
 			else if (headers.get(Message::Headers::Standard::TransferEncoding) == "Chunked")
 				return body->sendChunked(sock, s_maxRetryCount, s_maxBodySize);
 			else throw std::runtime_error("No transfer method specified for the body");
 		}
 	}
 
+	bool Sender::gatherPayload(std::unique_ptr<Message>& message, std::string_view& payload)
+	{
+		auto& body = message->getBody();
+		payload = {};
+		if (body == nullptr)
+			return true;
+
+		auto contentLength = message->getHeaders().get(Message::Headers::Standard::ContentLength);
+		if (body->getType() != Body::Type::STRING || contentLength == "")
+			return false;
+
+		auto data = static_cast<StringBody*>(body.get())->view();
+		if (data.size() > s_maxBodySize)
+			throw std::runtime_error("Body size exceeds maximum allowed size");
+		payload = data.substr(0, std::min<size_t>(std::stoull(std::string(contentLength)), data.size()));
+		return true;
+	}
+
 	size_t Sender::send(Socket& sock, std::unique_ptr<Message>& message)
 	{
 		if (message == nullptr)
 			throw std::runtime_error("trying to send empty message");
-		size_t bytesSent = 0;
-		bytesSent += sendHeaders(sock, message);
+
+		// status line, headers and an in memory body leave in a single gathered write
+		std::string headers = serializeHeaders(message);
+		std::string_view payload;
+		if (gatherPayload(message, payload)) {
+			if (!sock.usesZeroCopy(headers.size() + payload.size()))
+				return sock.sendCommited({ headers, payload }, s_maxRetryCount);
+
+			// the kernel reads a zero copy send after it returned, so the body moves to the socket until it's done
+			auto buffers = std::make_shared<ZeroCopyBuffers>(ZeroCopyBuffers{ std::move(headers), std::move(message->getBody()) });
+			return sock.sendCommited({ buffers->headers, payload }, buffers, s_maxRetryCount);
+		}
+
+		// streamed bodies follow right away, MSG_MORE lets the headers share a segment with the first body bytes
+		size_t bytesSent = sock.sendCommited({ headers }, s_maxRetryCount, true);
 		bytesSent += sendBody(sock, message);
 		return bytesSent;
 	}
 
-}
\ No newline at end of file
+	void Sender::asyncSend(IOContext& context, Socket& sock,
+		std::unique_ptr<Message>& message, std::function<void(size_t)> callback)
+	{
+		if (context.hasUring())
+		{
+			uringSend(context, sock, message, [&context, callback](size_t bytesSent) {
+				context.postParserCallback(bytesSent, callback);
+				});
+			return;
+		}
+
+		context.postWhenReady(sock, Reactor::Event::Write, [&context, &sock, &message, callback]() {
+			try
+			{
+				context.postParserCallback(send(sock, message), callback);
+			}
+			catch (const std::exception& e)
+			{
+				context.postParserCallback(0, callback);
+			}
+			});
+	}
+
+	Task<size_t> Sender::asyncSend(IOContext& context, Socket& sock, std::unique_ptr<Message>& message)
+	{
+		if (message == nullptr)
+			throw std::runtime_error("trying to send empty message");
+
+		std::string headers = serializeHeaders(message);
+		std::string_view payload;
+		std::vector<std::string_view> buffers{ headers };
+		bool gathered = gatherPayload(message, payload);
+		if (gathered)
+			buffers.push_back(payload);
+
+		size_t bytesSent = co_await sock.asyncSend(context, std::move(buffers));
+		if (!gathered)
+			bytesSent += sendBody(sock, message);
+		co_return bytesSent;
+	}
+
+	void Sender::uringSend(IOContext& context, Socket& sock,
+		std::unique_ptr<Message>& message, std::function<void(size_t)> callback)
+	{
+		if (message == nullptr)
+			throw std::runtime_error("trying to send empty message");
+
+		// zero copy bodies go through the socket, it holds them until the kernel reports the pages released
+		std::string_view payload;
+		if (!gatherPayload(message, payload) || sock.usesZeroCopy(payload.size()))
+		{
+			context.post([&sock, &message, callback]() {
+				size_t bytesSent = 0;
+				try
+				{
+					bytesSent = send(sock, message);
+				}
+				catch (const std::exception& e)
+				{
+					std::cerr << "Error sending message: " << e.what() << std::endl;
+				}
+				callback(bytesSent);
+				});
+			return;
+		}
+
+		// the header string has to outlive the submission, the callback keeps it alive
+		auto headers = std::make_shared<std::string>(serializeHeaders(message));
+		context.getUring().asyncSend(sock.getHandle(), { *headers, payload }, [headers, callback](int bytesSent) {
+			callback(bytesSent > 0 ? static_cast<size_t>(bytesSent) : 0);
+			});
+	}
+
+}
@@ -7,6 +7,15 @@ namespace Network::HTTP
         try
         {
             accept();
+
+            if (m_shards) {
+                m_shards->run();
+                return;
+            }
+
+            std::vector<std::jthread> shards;
+            for (size_t i = 1; i < m_listeners.size(); i++)
+                shards.emplace_back([&context = m_listeners[i].context]() { context.run(); });
             m_context.run();
         }
         catch (std::exception e)
@@ -17,35 +26,72 @@ namespace Network::HTTP
 
     void Server::accept()
     {
-        m_acceptor.asyncAccept([this](Socket&& socket) {
-            accept();
+        for (auto& listener : m_listeners)
+            accept(listener);
+    }
+
+    void Server::accept(Listener& listener)
+    {
+        listener.acceptor->asyncAccept([this, &listener](Socket&& socket) {
+            accept(listener);
             m_activeSessions++;
-            std::make_shared<Session>(
-                std::move(socket),
-                [this](std::unique_ptr<Message>& message) -> std::unique_ptr<Body> {
-                    return chooseBodyType(message); //not thread safe
-                },
-                [this](std::unique_ptr<Message>& message) {
-                    return handleMessage(message);
-                }, std::to_string(m_sessionCounter)
-                    )->startAssync(m_context, [this](const IOContext::SessionData& data) {
-                    //// Log session statistics
-                    //std::cout << "Session ended - Stats:\n"
-                    //    << "  Bytes sent: " << data.bytesSent << "\n"
-                    //    << "  Bytes received: " << data.bytesReceived << "\n"
-                    //    << "  Requests handled: " << data.iterationCount << "\n";
-
-                    // Update server metrics
-                    m_totalBytesSent += data.bytesSent;
-                    m_totalBytesReceived += data.bytesReceived;
-                    m_totalRequests += data.iterationCount;
-                    m_activeSessions--;
-                        });
-
-                m_sessionCounter++;
+            Session::BodyHandlerFunction bodyHandler = [this](std::unique_ptr<Message>& message) -> std::unique_ptr<Body> {
+                return chooseBodyType(message); //not thread safe
+                };
+
+            std::shared_ptr<Session> session;
+            if (m_hasAsyncHandlers) {
+                session = std::make_shared<Session>(std::move(socket), std::move(bodyHandler),
+                    Session::AsyncResponseHandlerFunction([this](std::unique_ptr<Message>& message) {
+                        return handleMessageAsync(message);
+                        }), std::to_string(m_sessionCounter));
+            }
+            else {
+                session = std::make_shared<Session>(std::move(socket), std::move(bodyHandler),
+                    Session::ResponseHandlerFunction([this](std::unique_ptr<Message>& message) {
+                        return handleMessage(message);
+                        }), std::to_string(m_sessionCounter));
+            }
+            session->setTimeouts(m_timeouts);
+            if (m_timingHandler)
+                session->setTimingHandler(m_timingHandler);
+            if (m_tcpInfoInterval)
+                session->setTcpInfoSampling(*m_tcpInfoInterval, [this](const Socket::TcpInfo& info) {
+                    m_tcpStatistics.record(info);
+                    });
+            session->startAssync(listener.context, [this](const IOContext::SessionData& data) {
+                //// Log session statistics
+                //std::cout << "Session ended - Stats:\n"
+                //    << "  Bytes sent: " << data.bytesSent << "\n"
+                //    << "  Bytes received: " << data.bytesReceived << "\n"
+                //    << "  Requests handled: " << data.iterationCount << "\n";
+
+                // Update server metrics
+                m_totalBytesSent += data.bytesSent;
+                m_totalBytesReceived += data.bytesReceived;
+                m_totalRequests += data.iterationCount;
+                m_totalZeroCopyBytes += data.zeroCopyBytes;
+                if (data.tcpInfo)
+                    m_tcpStatistics.record(*data.tcpInfo);
+                m_activeSessions--;
+                });
+
+            m_sessionCounter++;
             });
     }
 
+    Task<std::unique_ptr<Message>> Server::handleMessageAsync(std::unique_ptr<Message>& msg)
+    {
+        if (msg->getType() == Message::Type::Request)
+        {
+            auto& req = static_cast<Request&>(*msg);
+            auto& handler = m_asyncHandlers[static_cast<size_t>(req.getMethod())];
+            if (handler)
+                co_return co_await handler(req);
+        }
+        co_return handleMessage(msg);
+    }
+
     std::unique_ptr<Body> Server::chooseBodyType(std::unique_ptr<Message>& msg) {
         std::unique_ptr<Body> body;
         auto& headers = msg->getHeaders();
@@ -88,7 +134,7 @@ namespace Network::HTTP
         else {
             auto contentLength = headers.get(Message::Headers::Standard::ContentLength);
             if (contentLength != "") {
-                size_t length = std::stoul(contentLength);
+                size_t length = std::stoul(std::string(contentLength));
                 if (length > 1024 * 1024) //1MB
                     body = std::make_unique<FileBody>("Receives/Temporary" +
                         std::to_string(m_temporaryFileCounter.load()) + ".bin");
@@ -0,0 +1,179 @@
+#include "../include/ShardedIOContext.h"
+
+#include <latch>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#endif
+
+#ifdef _WIN32
+
+std::vector<size_t> ShardedIOContext::availableCores() {
+	std::vector<size_t> cores(std::thread::hardware_concurrency());
+	for (size_t i = 0; i < cores.size(); i++)
+		cores[i] = i;
+	return cores;
+}
+
+// affinity masks only cover the first processor group
+void ShardedIOContext::pinThread(std::thread& thread, size_t core) {
+	if (core >= 64 || SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << core) == 0)
+		throw std::runtime_error("Failed to pin thread to core " + std::to_string(core));
+}
+
+void ShardedIOContext::pinCurrentThread(size_t core) {
+	if (core >= 64 || SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << core) == 0)
+		throw std::runtime_error("Failed to pin thread to core " + std::to_string(core));
+}
+
+#else
+
+// containers and taskset narrow the set, sharding over cores we can't run on would only stack shards up
+std::vector<size_t> ShardedIOContext::availableCores() {
+	std::vector<size_t> cores;
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+		for (size_t core = 0; core < CPU_SETSIZE; core++)
+			if (CPU_ISSET(core, &set))
+				cores.push_back(core);
+	}
+	if (cores.empty()) {
+		for (size_t core = 0; core < std::thread::hardware_concurrency(); core++)
+			cores.push_back(core);
+	}
+	return cores;
+}
+
+static void setAffinity(pthread_t thread, size_t core) {
+	if (core >= CPU_SETSIZE)
+		throw std::runtime_error("Failed to pin thread to core " + std::to_string(core) + ": core out of range");
+
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(core, &set);
+	int result = pthread_setaffinity_np(thread, sizeof(set), &set);
+	if (result != 0)
+		throw std::runtime_error("Failed to pin thread to core " + std::to_string(core) + ": " + strerror(result));
+}
+
+void ShardedIOContext::pinThread(std::thread& thread, size_t core) {
+	setAffinity(thread.native_handle(), core);
+}
+
+void ShardedIOContext::pinCurrentThread(size_t core) {
+	setAffinity(pthread_self(), core);
+}
+
+#endif
+
+ShardedIOContext::ShardedIOContext(IOContext::Backend backend, std::vector<size_t> cores /*= {}*/,
+	size_t threadsPerShard /*= 0*/) :
+	m_cores(cores.empty() ? availableCores() : std::move(cores)) {
+	if (threadsPerShard == 0)
+		threadsPerShard = backend == IOContext::Backend::Blocking ? IOContext::defaultThreadCount(backend) /
+			std::max(1u, std::thread::hardware_concurrency()) : 1;
+
+	for (size_t i = 0; i < m_cores.size(); i++) {
+		m_shards.push_back(std::make_unique<IOContext>(backend, threadsPerShard));
+		pinShard(i);
+	}
+}
+
+ShardedIOContext::ShardedIOContext(IOContext::Backend backend, size_t shardCount, size_t threadsPerShard /*= 0*/) :
+	ShardedIOContext(backend, [shardCount]() {
+		auto cores = availableCores();
+		if (shardCount == 0 || shardCount > cores.size())
+			throw std::runtime_error("Can't run " + std::to_string(shardCount) + " shards on " +
+				std::to_string(cores.size()) + " cores");
+		cores.resize(shardCount);
+		return cores;
+	}(), threadsPerShard) {
+}
+
+ShardedIOContext::~ShardedIOContext() {
+	stop();
+}
+
+void ShardedIOContext::pinShard(size_t index) {
+	auto& shard = *m_shards[index];
+	auto core = m_cores[index];
+
+	if (shard.hasUring())
+		pinThread(shard.getUring().getThread(), core);
+	else if (shard.hasReactor())
+		pinThread(shard.getReactor().getThread(), core);
+
+	// every task holds its worker until all of them arrived, so each worker takes exactly one
+	auto threadCount = shard.getThreadCount();
+	auto arrived = std::make_shared<std::latch>(threadCount);
+	auto failures = std::make_shared<std::atomic<size_t>>(0);
+	for (size_t i = 0; i < threadCount; i++) {
+		shard.post([arrived, failures, core]() {
+			try {
+				pinCurrentThread(core);
+			}
+			catch (const std::exception& e) {
+				std::cerr << e.what() << std::endl;
+				(*failures)++;
+			}
+			arrived->arrive_and_wait();
+			});
+	}
+	arrived->wait();
+
+	if (failures->load() > 0)
+		throw std::runtime_error("Failed to pin the pool of shard " + std::to_string(index));
+}
+
+std::vector<std::reference_wrapper<IOContext>> ShardedIOContext::contexts() {
+	std::vector<std::reference_wrapper<IOContext>> contexts;
+	for (auto& shard : m_shards)
+		contexts.push_back(*shard);
+	return contexts;
+}
+
+bool ShardedIOContext::matchesCpuIndices() const {
+	for (size_t i = 0; i < m_cores.size(); i++)
+		if (m_cores[i] != i)
+			return false;
+	return true;
+}
+
+void ShardedIOContext::run() {
+	if (m_stopped)
+		return;
+	for (size_t i = 0; i < m_shards.size(); i++) {
+		m_threads.emplace_back([this, i]() {
+			try {
+				pinCurrentThread(m_cores[i]);
+			}
+			catch (const std::exception& e) {
+				std::cerr << e.what() << std::endl;
+			}
+			m_shards[i]->run();
+			});
+	}
+
+	for (auto& thread : m_threads)
+		thread.join();
+	m_threads.clear();
+}
+
+void ShardedIOContext::stop() {
+	if (m_stopped.exchange(true))
+		return;
+	for (auto& shard : m_shards)
+		shard->stop();
+}
+
+std::vector<ShardedIOContext::ShardStats> ShardedIOContext::getStats() const {
+	std::vector<ShardStats> stats;
+	for (size_t i = 0; i < m_shards.size(); i++)
+		stats.push_back(ShardStats{ m_cores[i], m_shards[i]->getStats() });
+	return stats;
+}
@@ -1,17 +1,28 @@
 #include "../include/Socket.h"
+#include "../include/IOContext.h"
 
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <afunix.h>
 #pragma comment(lib, "Ws2_32.lib")
 #else
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <linux/filter.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
 #include <sys/ioctl.h>
-#include <sys/select.h>
+#include <poll.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <string.h>
+#include <limits.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/un.h>
 #include <arpa/inet.h>
 #endif
 
@@ -102,6 +113,45 @@ namespace Network {
         }
     }
 
+    // abstract names aren't null terminated, their length is part of the address
+    static socklen_t makeUnixAddress(std::string_view path, sockaddr_un& address)
+    {
+        if (path.empty() || path.size() >= sizeof(address.sun_path))
+            throw std::runtime_error("Invalid unix socket path: " + std::string(path));
+
+        bool abstract = Socket::isAbstractPath(path);
+#ifdef _WIN32
+        if (abstract)
+            throw std::runtime_error("Abstract unix sockets are not supported on this platform");
+#endif
+        address = {};
+        address.sun_family = AF_UNIX;
+        std::copy(path.begin(), path.end(), address.sun_path);
+        if (abstract) {
+            address.sun_path[0] = '\0';
+            return static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size());
+        }
+        return static_cast<socklen_t>(sizeof(address));
+    }
+
+    void Socket::bind(std::string_view path) {
+        if (m_domain != Domain::Unix)
+            throw std::runtime_error("Binding a path needs a unix domain socket");
+
+        sockaddr_un address;
+        socklen_t length = makeUnixAddress(path, address);
+
+        // a socket file left behind by a previous run would fail the bind with address in use
+        std::error_code error;
+        if (!isAbstractPath(path) && std::filesystem::is_socket(path, error))
+            std::filesystem::remove(path, error);
+
+        if (::bind(m_sockfd, (struct sockaddr*)&address, length) < 0) {
+            throw std::runtime_error("Bind failed: " +
+                getLastErrorString());
+        }
+    }
+
     void Socket::listen(int backlog /*= DEFAULT_BACKLOG*/) {
         if (::listen(m_sockfd, backlog) < 0) {
             throw std::runtime_error("Listen failed: " +
@@ -113,7 +163,11 @@ namespace Network {
         struct sockaddr_in client_addr;
         socklen_t client_len = sizeof(client_addr);
 
+#ifdef _WIN32
         Handle clientfd = ::accept(m_sockfd, (struct sockaddr*)&client_addr, &client_len);
+#else
+        Handle clientfd = ::accept4(m_sockfd, (struct sockaddr*)&client_addr, &client_len, SOCK_CLOEXEC);
+#endif
 
         if (clientfd < 0) {
             throw std::runtime_error("Accept failed: " +
@@ -127,6 +181,54 @@ namespace Network {
         return client;
     }
 
+    size_t Socket::acceptBatch(std::vector<Socket>& clients, size_t maxCount) {
+        size_t accepted = 0;
+        while (accepted < maxCount) {
+            struct sockaddr_in client_addr;
+            socklen_t client_len = sizeof(client_addr);
+
+#ifdef _WIN32
+            Handle clientfd = ::accept(m_sockfd, (struct sockaddr*)&client_addr, &client_len);
+#else
+            Handle clientfd = ::accept4(m_sockfd, (struct sockaddr*)&client_addr, &client_len,
+                SOCK_NONBLOCK | SOCK_CLOEXEC);
+#endif
+            if (clientfd < 0) {
+                auto error = getLastError();
+                if (error == Error::WouldBlock)
+                    break;
+                if (error == Error::Interrupted || error == Error::ConnectionAborted)
+                    continue;
+                // whatever was accepted so far is still handed out, the error shows up again on the next drain
+                if (accepted > 0)
+                    break;
+                throw std::runtime_error("Accept failed: " + getErrorString(error));
+            }
+
+            Socket client(clientfd, reinterpret_cast<AddressIn&>(client_addr));
+#ifdef _WIN32
+            client.setNonBlocking();
+#else
+            client.m_nonBlocking = true;
+#endif
+            clients.push_back(std::move(client));
+            accepted++;
+        }
+        if (accepted > 0)
+            m_isConnected = true;
+        return accepted;
+    }
+
+    Socket Socket::fromHandle(Handle handle, bool nonBlocking /*= false*/) {
+        struct sockaddr_in client_addr{};
+        socklen_t client_len = sizeof(client_addr);
+        getpeername(handle, (struct sockaddr*)&client_addr, &client_len);
+
+        Socket client(handle, reinterpret_cast<AddressIn&>(client_addr));
+        client.m_nonBlocking = nonBlocking;
+        return client;
+    }
+
     void Socket::connect(const char* ip, uint16_t port) {
         m_addr.sin_family = AF_INET;
         m_addr.sin_port = htons(port);
@@ -141,6 +243,20 @@ namespace Network {
         m_isConnected = true;
     }
 
+    void Socket::connect(std::string_view path) {
+        if (m_domain != Domain::Unix)
+            throw std::runtime_error("Connecting to a path needs a unix domain socket");
+
+        sockaddr_un address;
+        socklen_t length = makeUnixAddress(path, address);
+
+        if (::connect(m_sockfd, (struct sockaddr*)&address, length) < 0) {
+            throw std::runtime_error("Connect failed: " +
+                getLastErrorString());
+        }
+        m_isConnected = true;
+    }
+
     int Socket::send(const char* data, size_t len) {
 #ifdef _WIN32
         return ::send(m_sockfd, data, len, 0);
@@ -149,13 +265,12 @@ namespace Network {
 #endif
     }
 
-    int Socket::sendCommited(const char* data, size_t len, size_t maxRetryCount)
+    int Socket::sendCommited(const char* data, size_t len, Deadline deadline)
     {
         if (m_sockfd < 0) {
             throw std::runtime_error("Client socket is not connected: " +
                 getLastErrorString());
         }
-        size_t retryCount = 0;
         size_t sentTotal = 0;
         int bytesSent = 0;
 
@@ -167,86 +282,346 @@ namespace Network {
             bytesSent = ::write(m_sockfd, data + sentTotal, len - sentTotal);
 #endif
             if (bytesSent > 0) {
-                // Reset retry count on successful send
-                retryCount = 0;
+                deadline.progress();
                 sentTotal += bytesSent;
             }
             else if (bytesSent == 0) {
                 // For send(), 0 indicates an error condition
                 throw std::runtime_error("Connection closed unexpectedly");
             }
-            else if (bytesSent < 0) {
-                auto error = Socket::getLastError();
-                if (error == Socket::Error::Interrupted ||
-                    error == Socket::Error::WouldBlock) {
-                    if (++retryCount > maxRetryCount) {
-                        std::cerr << "Max retries exceeded" << std::endl;
-                        break;
-                    }
-                    // Exponential backoff: 10ms, 20ms, 40ms, 80ms, 160ms
-                    std::this_thread::sleep_for(
-                        std::chrono::milliseconds(10 * (1 << (retryCount - 1)))
-                    );
-                    continue;
-                }
-                else {
-                    std::cerr << "Error sending to socket: " << Socket::getErrorString(error) << std::endl;
-                    break;
-                }
+            else if (!retryAfterError(true, deadline)) {
+                break;
             }
         }
         return sentTotal;
     }
 
-    int Socket::sendLoop(char* buffer, size_t len, size_t totalStart, size_t maxRetryCount,
-        std::function<bool(char*&, size_t&, size_t, size_t&)> handler)
+    int Socket::sendCommited(const std::vector<std::string_view>& buffers, Deadline deadline, bool more /*= false*/)
+    {
+        return sendAll(buffers, deadline, more, false);
+    }
+
+    int Socket::sendCommited(const std::vector<std::string_view>& buffers, std::shared_ptr<void> owner,
+        Deadline deadline, bool more /*= false*/)
+    {
+#ifdef _WIN32
+        return sendAll(buffers, deadline, more, false);
+#else
+        // completions of earlier sends are picked up here too, so a busy connection doesn't pile up owners
+        if (m_zeroCopyOutstanding > 0)
+            drainErrorQueue();
+
+        size_t total = 0;
+        for (auto buffer : buffers)
+            total += buffer.size();
+        if (!usesZeroCopy(total))
+            return sendAll(buffers, deadline, more, false);
+
+        uint32_t firstId = m_zeroCopyNextId;
+        int sentTotal = sendAll(buffers, deadline, more, true);
+        if (m_zeroCopyNextId != firstId)
+            m_zeroCopyHeld.emplace_back(m_zeroCopyNextId - 1, std::move(owner));
+        return sentTotal;
+#endif
+    }
+
+    int Socket::sendAll(const std::vector<std::string_view>& buffers, Deadline deadline, bool more, bool zeroCopy)
     {
         if (m_sockfd < 0) {
             throw std::runtime_error("Client socket is not connected: " +
                 getLastErrorString());
         }
-        size_t retryCount = 0;
-        int bytesSent = 0;
-        bool shouldSend = true;
 
-        while (shouldSend) {
+#ifdef _WIN32
+        std::vector<WSABUF> vectors;
+        for (auto buffer : buffers)
+            if (!buffer.empty())
+                vectors.push_back(WSABUF{ static_cast<ULONG>(buffer.size()), const_cast<char*>(buffer.data()) });
+#else
+        std::vector<iovec> vectors;
+        for (auto buffer : buffers)
+            if (!buffer.empty())
+                vectors.push_back(iovec{ const_cast<char*>(buffer.data()), buffer.size() });
+#endif
+
+        size_t sentTotal = 0;
+        size_t current = 0; // first vector that still has unsent bytes
+
+        while (current < vectors.size()) {
 
 #ifdef _WIN32
-            bytesSent = ::send(m_sockfd, buffer, len, 0);
+            DWORD sent = 0;
+            int bytesSent = WSASend(m_sockfd, vectors.data() + current,
+                static_cast<DWORD>(vectors.size() - current), &sent, 0, nullptr, nullptr) == 0 ?
+                static_cast<int>(sent) : -1;
 #else
-            bytesSent = ::write(m_sockfd, buffer, len);
+            msghdr header{};
+            header.msg_iov = vectors.data() + current;
+            header.msg_iovlen = std::min<size_t>(vectors.size() - current, IOV_MAX);
+            auto bytesSent = ::sendmsg(m_sockfd, &header,
+                MSG_NOSIGNAL | (more ? MSG_MORE : 0) | (zeroCopy ? MSG_ZEROCOPY : 0));
+
+            // pinned pages count against optmem, once that runs out the rest is copied
+            if (bytesSent < 0 && zeroCopy && errno == ENOBUFS) {
+                zeroCopy = false;
+                continue;
+            }
+            if (bytesSent > 0 && zeroCopy) {
+                m_zeroCopyInFlight.push_back(bytesSent);
+                m_zeroCopyOutstanding++;
+                m_zeroCopyNextId++;
+            }
+            else if (bytesSent > 0 && m_zeroCopyThreshold > 0) {
+                m_zeroCopyStats.copiedBytes += bytesSent;
+            }
 #endif
             if (bytesSent > 0) {
-                // Reset retry count on successful send
-                retryCount = 0;
-                totalStart += bytesSent;
-                shouldSend = handler(buffer, len, bytesSent, totalStart);
+                deadline.progress();
+                sentTotal += bytesSent;
+
+                // drop fully written vectors and advance into a partially written one
+                size_t advance = bytesSent;
+                while (current < vectors.size()) {
+#ifdef _WIN32
+                    auto& vector = vectors[current];
+                    if (advance < vector.len) {
+                        vector.buf += advance;
+                        vector.len -= static_cast<ULONG>(advance);
+                        break;
+                    }
+                    advance -= vector.len;
+#else
+                    auto& vector = vectors[current];
+                    if (advance < vector.iov_len) {
+                        vector.iov_base = static_cast<char*>(vector.iov_base) + advance;
+                        vector.iov_len -= advance;
+                        break;
+                    }
+                    advance -= vector.iov_len;
+#endif
+                    current++;
+                }
             }
             else if (bytesSent == 0) {
                 // For send(), 0 indicates an error condition
                 throw std::runtime_error("Connection closed unexpectedly");
             }
-            else if (bytesSent < 0) {
-                auto error = Socket::getLastError();
-                if (error == Socket::Error::Interrupted ||
-                    error == Socket::Error::WouldBlock) {
-                    if (++retryCount > maxRetryCount) {
-                        std::cerr << "Max retries exceeded" << std::endl;
+            else if (!retryAfterError(true, deadline)) {
+                break;
+            }
+        }
+        return sentTotal;
+    }
+
+    bool Socket::collectZeroCopy()
+    {
+        if (m_zeroCopyOutstanding > 0)
+            drainErrorQueue();
+        return m_zeroCopyOutstanding == 0;
+    }
+
+#ifdef _WIN32
+    bool Socket::awaitZeroCopy(const Deadline& deadline)
+    {
+        return true;
+    }
+
+    void Socket::releaseZeroCopy()
+    {
+    }
+
+    size_t Socket::drainErrorQueue()
+    {
+        return 0;
+    }
+#else
+    bool Socket::awaitZeroCopy(const Deadline& deadline)
+    {
+        // the error queue never blocks, an empty one raises POLLERR once a completion arrives
+        while (!collectZeroCopy()) {
+            if (!waitEvents(0, deadline)) {
+                std::cerr << "Deadline exceeded with " << m_zeroCopyOutstanding << " zero copy sends in flight" << std::endl;
+                return false;
+            }
+
+            // a shut down socket keeps raising POLLHUP, the completions can still be a moment behind that
+            if (drainErrorQueue() == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    void Socket::releaseZeroCopy()
+    {
+        while (!m_zeroCopyInFlight.empty() && m_zeroCopyInFlight.front() == 0) {
+            m_zeroCopyInFlight.pop_front();
+            m_zeroCopyFirstId++;
+        }
+
+        // ids wrap around, the distance to the oldest send in flight tells whether an owner's last one is done
+        while (!m_zeroCopyHeld.empty() && (m_zeroCopyInFlight.empty() ||
+            static_cast<int32_t>(m_zeroCopyFirstId - m_zeroCopyHeld.front().first) > 0))
+            m_zeroCopyHeld.pop_front();
+    }
+
+    static Socket::Timestamp toTimestamp(const timespec& stamp)
+    {
+        return Socket::Timestamp(std::chrono::duration_cast<Socket::Timestamp::duration>(
+            std::chrono::seconds(stamp.tv_sec) + std::chrono::nanoseconds(stamp.tv_nsec)));
+    }
+
+    size_t Socket::drainErrorQueue()
+    {
+        size_t drained = 0;
+        while (true) {
+            char control[CMSG_SPACE(sizeof(sock_extended_err)) + CMSG_SPACE(sizeof(sockaddr_in6)) +
+                CMSG_SPACE(sizeof(scm_timestamping))];
+            msghdr message{};
+            message.msg_control = control;
+            message.msg_controllen = sizeof(control);
+
+            if (::recvmsg(m_sockfd, &message, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+                auto error = getLastError();
+                if (error == Error::Interrupted)
+                    continue;
+                if (error != Error::WouldBlock)
+                    std::cerr << "Error reading the socket error queue: " << getErrorString(error) << std::endl;
+                releaseZeroCopy();
+                return drained;
+            }
+            drained++;
+
+            // a timestamp notification carries the time and the extended error with its kind and key separately
+            const timespec* stamp = nullptr;
+            for (cmsghdr* entry = CMSG_FIRSTHDR(&message); entry != nullptr; entry = CMSG_NXTHDR(&message, entry)) {
+                if (entry->cmsg_level == SOL_SOCKET && entry->cmsg_type == SCM_TIMESTAMPING) {
+                    stamp = &reinterpret_cast<const scm_timestamping*>(CMSG_DATA(entry))->ts[0];
+                    continue;
+                }
+                if (!(entry->cmsg_level == SOL_IP && entry->cmsg_type == IP_RECVERR) &&
+                    !(entry->cmsg_level == SOL_IPV6 && entry->cmsg_type == IPV6_RECVERR))
+                    continue;
+
+                auto* completion = reinterpret_cast<sock_extended_err*>(CMSG_DATA(entry));
+                if (completion->ee_errno == ENOMSG && completion->ee_origin == SO_EE_ORIGIN_TIMESTAMPING && stamp) {
+                    auto time = toTimestamp(*stamp);
+                    if (completion->ee_info == SCM_TSTAMP_SND)
+                        m_transmitted = TransmitStamp{ completion->ee_data, time };
+                    else if (completion->ee_info == SCM_TSTAMP_ACK)
+                        m_acknowledged = TransmitStamp{ completion->ee_data, time };
+                    continue;
+                }
+                if (completion->ee_errno != 0 || completion->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                    continue;
+
+                // ids ee_info..ee_data are done, copied means the kernel fell back to copying them (e.g. loopback)
+                bool copied = completion->ee_code & SO_EE_CODE_ZEROCOPY_COPIED;
+                for (uint32_t id = completion->ee_info; ; id++) {
+                    uint32_t index = id - m_zeroCopyFirstId;
+                    if (index < m_zeroCopyInFlight.size() && m_zeroCopyInFlight[index] > 0) {
+                        (copied ? m_zeroCopyStats.copiedBytes : m_zeroCopyStats.zeroCopyBytes) += m_zeroCopyInFlight[index];
+                        m_zeroCopyInFlight[index] = 0;
+                        m_zeroCopyOutstanding--;
+                    }
+                    if (id == completion->ee_data)
+                        break;
+                }
+            }
+        }
+    }
+#endif
+
+#ifdef _WIN32
+    int Socket::sendFile(int fileHandle, size_t offset, size_t len, Deadline deadline)
+    {
+        throw std::runtime_error("sendFile is not supported on this platform");
+    }
+#else
+    int Socket::sendFile(int fileHandle, size_t offset, size_t len, Deadline deadline)
+    {
+        if (m_sockfd < 0) {
+            throw std::runtime_error("Client socket is not connected: " +
+                getLastErrorString());
+        }
+        size_t sentTotal = 0;
+        ssize_t bytesSent = 0;
+
+        // splice fallback state, bytes already moved into the pipe survive a would-block on the socket
+        int pipeHandles[2] = { -1, -1 };
+        size_t piped = 0;
+        bool endOfFile = false;
+
+        while (sentTotal < len) {
+
+            if (pipeHandles[0] < 0) {
+                off_t position = offset + sentTotal;
+                bytesSent = ::sendfile(m_sockfd, fileHandle, &position, len - sentTotal);
+                if (bytesSent < 0 && (errno == EINVAL || errno == ENOSYS)) {
+                    if (pipe2(pipeHandles, O_CLOEXEC) < 0) {
+                        std::cerr << "Error creating splice pipe: " << getLastErrorString() << std::endl;
                         break;
                     }
-                    // Exponential backoff: 10ms, 20ms, 40ms, 80ms, 160ms
-                    std::this_thread::sleep_for(
-                        std::chrono::milliseconds(10 * (1 << (retryCount - 1)))
-                    );
                     continue;
                 }
-                else {
-                    std::cerr << "Error sending to socket: " << Socket::getErrorString(error) << std::endl;
-                    break;
+            }
+            else {
+                if (piped == 0) {
+                    loff_t position = offset + sentTotal;
+                    auto filled = ::splice(fileHandle, &position, pipeHandles[1], nullptr,
+                        len - sentTotal, SPLICE_F_MOVE);
+                    if (filled <= 0) {
+                        endOfFile = filled == 0;
+                        if (filled < 0)
+                            std::cerr << "Error reading file for splice: " << getLastErrorString() << std::endl;
+                        break;
+                    }
+                    piped = filled;
                 }
+                bytesSent = ::splice(pipeHandles[0], nullptr, m_sockfd, nullptr, piped,
+                    SPLICE_F_MOVE | SPLICE_F_MORE);
+                if (bytesSent > 0)
+                    piped -= bytesSent;
             }
+
+            if (bytesSent > 0) {
+                deadline.progress();
+                sentTotal += bytesSent;
+            }
+            else if (bytesSent == 0) {
+                // sendfile returns 0 once the file ends
+                endOfFile = true;
+                break;
+            }
+            else if (!retryAfterError(true, deadline)) {
+                break;
+            }
+        }
+
+        if (pipeHandles[0] >= 0) {
+            ::close(pipeHandles[0]);
+            ::close(pipeHandles[1]);
+        }
+        if (endOfFile)
+            throw std::runtime_error("File ended before " + std::to_string(len) + " bytes were sent");
+        return sentTotal;
+    }
+#endif
+
+    bool Socket::retryAfterError(bool forWrite, const Deadline& deadline) {
+        auto error = Socket::getLastError();
+        if (error == Socket::Error::Interrupted)
+            return true;
+        if (error == Socket::Error::WouldBlock) {
+            // wake up as soon as the socket is ready again instead of sleeping
+            if (!waitReady(forWrite, deadline)) {
+                std::cerr << "Deadline exceeded" << std::endl;
+                return false;
+            }
+            return true;
         }
-        return totalStart;
+        std::cerr << (forWrite ? "Error sending to socket: " : "Error reading from socket: ")
+            << Socket::getErrorString(error) << std::endl;
+        return false;
     }
 
     int Socket::receive(char* buffer, size_t len) {
@@ -257,10 +632,102 @@ namespace Network {
 #ifdef _WIN32
         return ::recv(m_sockfd, buffer, len, 0);
 #else
-        return ::read(m_sockfd, buffer, len);
+        return m_timestamping ? receiveStamped(buffer, len) : ::read(m_sockfd, buffer, len);
+#endif
+    }
+
+    Task<size_t> Socket::asyncRead(IOContext& context, char* buffer, size_t len) {
+        while (true) {
+            auto bytesRead = receive(buffer, len);
+            if (bytesRead >= 0)
+                co_return static_cast<size_t>(bytesRead);
+
+            auto error = getLastError();
+            if (error == Error::Interrupted)
+                continue;
+            if (error != Error::WouldBlock)
+                throw std::runtime_error("Error reading from socket: " + getErrorString(error));
+
+            co_await asyncWaitReady(context, false);
+        }
+    }
+
+    Task<void> Socket::asyncWaitReady(IOContext& context, bool forWrite) {
+        if (usesErrorQueue())
+            drainErrorQueue();
+
+        // without a reactor the calling thread waits, the same way the blocking loops do
+        if (!context.hasReactor())
+            waitReady(forWrite, Deadline{});
+        else
+            co_await context.waitReady(*this, forWrite ? Reactor::Event::Write : Reactor::Event::Read);
+    }
+
+    int Socket::sendGathered(const std::vector<std::string_view>& buffers, size_t offset) {
+        if (m_sockfd < 0) {
+            throw std::runtime_error("Client socket is not connected: " +
+                getLastErrorString());
+        }
+
+#ifdef _WIN32
+        std::vector<WSABUF> vectors;
+#else
+        std::vector<iovec> vectors;
+#endif
+        for (auto buffer : buffers) {
+            if (offset >= buffer.size()) {
+                offset -= buffer.size();
+                continue;
+            }
+            buffer.remove_prefix(offset);
+            offset = 0;
+#ifdef _WIN32
+            vectors.push_back(WSABUF{ static_cast<ULONG>(buffer.size()), const_cast<char*>(buffer.data()) });
+#else
+            vectors.push_back(iovec{ const_cast<char*>(buffer.data()), buffer.size() });
+#endif
+        }
+        if (vectors.empty())
+            return 0;
+
+#ifdef _WIN32
+        DWORD sent = 0;
+        return WSASend(m_sockfd, vectors.data(), static_cast<DWORD>(vectors.size()), &sent, 0, nullptr, nullptr) == 0 ?
+            static_cast<int>(sent) : -1;
+#else
+        msghdr header{};
+        header.msg_iov = vectors.data();
+        header.msg_iovlen = std::min<size_t>(vectors.size(), IOV_MAX);
+        return ::sendmsg(m_sockfd, &header, MSG_NOSIGNAL);
 #endif
     }
 
+    Task<size_t> Socket::asyncSend(IOContext& context, std::vector<std::string_view> buffers) {
+        size_t total = 0;
+        for (auto buffer : buffers)
+            total += buffer.size();
+
+        size_t sentTotal = 0;
+        while (sentTotal < total) {
+            auto bytesSent = sendGathered(buffers, sentTotal);
+            if (bytesSent > 0) {
+                sentTotal += bytesSent;
+                continue;
+            }
+            if (bytesSent == 0)
+                throw std::runtime_error("Connection closed unexpectedly");
+
+            auto error = getLastError();
+            if (error == Error::Interrupted)
+                continue;
+            if (error != Error::WouldBlock)
+                throw std::runtime_error("Error sending to socket: " + getErrorString(error));
+
+            co_await asyncWaitReady(context, true);
+        }
+        co_return sentTotal;
+    }
+
     //returns available data size
     uint32_t Socket::checkDataAvailable()
     {
@@ -284,65 +751,28 @@ namespace Network {
         return bytesAvailable;
     }
 
-    int Socket::receiveLoop(char* buffer, size_t len, size_t totalStart, size_t maxRetryCount,
-        std::function<bool(char*&, size_t&, size_t, size_t&)> handler) {
-        if (m_sockfd < 0) {
-            throw std::runtime_error("Client socket is not connected: " +
-                getLastErrorString());
-        }
-        size_t retryCount = 0;
-        bool shouldRead = true;
-
-        while (shouldRead) {
-
+    void Socket::shutdown() {
+        if (m_sockfd < 0)
+            return;
+        ::shutdown(m_sockfd,
 #ifdef _WIN32
-            auto bytesRead = ::recv(m_sockfd, buffer, len, 0);
+            SD_BOTH
 #else
-            auto bytesRead = ::read(m_sockfd, buffer, len);
+            SHUT_RDWR
 #endif
-            if (bytesRead > 0) {
-                // Reset retry count on successful read
-                retryCount = 0;
-                totalStart += bytesRead;
-                shouldRead = handler(buffer, len, bytesRead, totalStart);
-            }
-            else if (bytesRead == 0) {
-                std::cout << "Connection closed by client" << std::endl;
-                break;
-            }
-            else if (bytesRead < 0) {
-                auto error = Socket::getLastError();
-                if (error == Socket::Error::Interrupted ||
-                    error == Socket::Error::WouldBlock) {
-                    if (++retryCount > maxRetryCount) {
-                        std::cerr << "Max retries exceeded" << std::endl;
-                        break;
-                    }
-                    // Exponential backoff: 10ms, 20ms, 40ms, 80ms, 160ms
-                    std::this_thread::sleep_for(
-                        std::chrono::milliseconds(10 * (1 << (retryCount - 1)))
-                    );
-                    continue;
-                }
-                else {
-                    std::cerr << "Error reading from socket: " << Socket::getErrorString(error) << std::endl;
-                    break;
-                }
-            }
-        }
-        return totalStart;
+        );
     }
 
     void Socket::close() {
         if (m_sockfd >= 0) {
-            // Shutdown gracefully first
-            shutdown(m_sockfd,
-#ifdef _WIN32
-                SD_BOTH
-#else
-                SHUT_RDWR
+#ifndef _WIN32
+            // the kernel may still read from the pages of a zero copy send, the owners are only released
+            // once it's done, a peer that stops acking is dropped by the kernel, which ends the wait too
+            // (sessions wait for the completions before they get here)
+            awaitZeroCopy(Deadline{});
 #endif
-            );
+            // Shutdown gracefully first
+            shutdown();
 
 #ifdef _WIN32
             closesocket(m_sockfd);
@@ -351,6 +781,9 @@ namespace Network {
 #endif
             m_sockfd = -1;  // Mark as closed
             m_isConnected = false;
+            m_zeroCopyInFlight.clear();
+            m_zeroCopyOutstanding = 0;
+            m_zeroCopyHeld.clear();
         }
     }
 
@@ -373,6 +806,41 @@ namespace Network {
         return *this;
     }
 
+    Socket& Socket::setReusePort(bool reuse /*= true*/) {
+#ifdef _WIN32
+        throw std::runtime_error("SO_REUSEPORT is not supported on this platform");
+#else
+        int value = reuse ? 1 : 0;
+        if (setsockopt(m_sockfd, SOL_SOCKET, SO_REUSEPORT, &value, sizeof(value)) < 0) {
+            throw std::runtime_error("Failed to set SO_REUSEPORT: " +
+                getLastErrorString());
+        }
+#endif
+        return *this;
+    }
+
+    Socket& Socket::setReusePortCpuSteering(uint32_t groupSize) {
+#ifdef _WIN32
+        throw std::runtime_error("Reuseport steering is not supported on this platform");
+#else
+        if (groupSize == 0)
+            throw std::runtime_error("Reuseport group can't be empty");
+
+        // A = cpu the connection arrived on; A %= groupSize; return A
+        sock_filter code[] = {
+            { BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) },
+            { BPF_ALU | BPF_MOD | BPF_K, 0, 0, groupSize },
+            { BPF_RET | BPF_A, 0, 0, 0 },
+        };
+        sock_fprog program{ static_cast<unsigned short>(std::size(code)), code };
+        if (setsockopt(m_sockfd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) < 0) {
+            throw std::runtime_error("Failed to attach reuseport steering program: " +
+                getLastErrorString());
+        }
+#endif
+        return *this;
+    }
+
     int Socket::getReceiveBufferSize() {
         if (m_sockfd < 0) {
             throw std::runtime_error("Socket is not connected: " +
@@ -413,6 +881,272 @@ namespace Network {
         }
     }
 
+    // int valued setsockopt, name ends up in the error message
+    static void setIntOption(Socket::Handle handle, int level, int option, int value, const char* name)
+    {
+#ifdef _WIN32
+        if (setsockopt(handle, level, option,
+            reinterpret_cast<const char*>(&value), sizeof(value)) == SOCKET_ERROR) {
+#else
+        if (setsockopt(handle, level, option,
+            &value, sizeof(value)) < 0) {
+#endif
+            throw std::runtime_error(std::string("Failed to set ") + name + ": " +
+                Socket::getLastErrorString());
+        }
+    }
+
+    int Socket::getSendBufferSize() {
+        if (m_sockfd < 0) {
+            throw std::runtime_error("Socket is not connected: " +
+                getLastErrorString());
+        }
+
+        int size = 0;
+        socklen_t optlen = sizeof(size);
+
+#ifdef _WIN32
+        if (getsockopt(m_sockfd, SOL_SOCKET, SO_SNDBUF,
+            reinterpret_cast<char*>(&size), &optlen) == SOCKET_ERROR) {
+#else
+        if (getsockopt(m_sockfd, SOL_SOCKET, SO_SNDBUF,
+            &size, &optlen) < 0) {
+#endif
+            throw std::runtime_error("Failed to get buffer size: " +
+                getLastErrorString());
+        }
+        return size;
+    }
+
+    Socket& Socket::setSendBufferSize(int size) {
+        setIntOption(m_sockfd, SOL_SOCKET, SO_SNDBUF, size, "SO_SNDBUF");
+        return *this;
+    }
+
+    Socket& Socket::setNoDelay(bool noDelay /*= true*/) {
+        setIntOption(m_sockfd, IPPROTO_TCP, TCP_NODELAY, noDelay ? 1 : 0, "TCP_NODELAY");
+        return *this;
+    }
+
+    Socket& Socket::setCork(bool cork /*= true*/) {
+#ifdef _WIN32
+        throw std::runtime_error("TCP_CORK is not supported on this platform");
+#else
+        setIntOption(m_sockfd, IPPROTO_TCP, TCP_CORK, cork ? 1 : 0, "TCP_CORK");
+#endif
+        return *this;
+    }
+
+    Socket& Socket::setQuickAck(bool quickAck /*= true*/) {
+#ifdef _WIN32
+        throw std::runtime_error("TCP_QUICKACK is not supported on this platform");
+#else
+        setIntOption(m_sockfd, IPPROTO_TCP, TCP_QUICKACK, quickAck ? 1 : 0, "TCP_QUICKACK");
+#endif
+        return *this;
+    }
+
+    Socket& Socket::setDeferAccept(const std::chrono::seconds& timeout) {
+#ifdef _WIN32
+        throw std::runtime_error("TCP_DEFER_ACCEPT is not supported on this platform");
+#else
+        setIntOption(m_sockfd, IPPROTO_TCP, TCP_DEFER_ACCEPT, static_cast<int>(timeout.count()), "TCP_DEFER_ACCEPT");
+#endif
+        return *this;
+    }
+
+    Socket& Socket::setFastOpen(int queueLength) {
+        setIntOption(m_sockfd, IPPROTO_TCP, TCP_FASTOPEN, queueLength, "TCP_FASTOPEN");
+        return *this;
+    }
+
+    Socket& Socket::setBusyPoll(const std::chrono::microseconds& duration) {
+#ifdef _WIN32
+        throw std::runtime_error("SO_BUSY_POLL is not supported on this platform");
+#else
+        setIntOption(m_sockfd, SOL_SOCKET, SO_BUSY_POLL, static_cast<int>(duration.count()), "SO_BUSY_POLL");
+#endif
+        return *this;
+    }
+
+    Socket& Socket::setUserTimeout(const std::chrono::milliseconds& timeout) {
+#ifdef _WIN32
+        throw std::runtime_error("TCP_USER_TIMEOUT is not supported on this platform");
+#else
+        setIntOption(m_sockfd, IPPROTO_TCP, TCP_USER_TIMEOUT, static_cast<int>(timeout.count()), "TCP_USER_TIMEOUT");
+#endif
+        return *this;
+    }
+
+    Socket& Socket::setZeroCopy(size_t threshold /*= s_defaultZeroCopyThreshold*/) {
+#ifdef _WIN32
+        throw std::runtime_error("SO_ZEROCOPY is not supported on this platform");
+#else
+        setIntOption(m_sockfd, SOL_SOCKET, SO_ZEROCOPY, threshold > 0 ? 1 : 0, "SO_ZEROCOPY");
+        m_zeroCopyThreshold = threshold;
+#endif
+        return *this;
+    }
+
+#ifdef _WIN32
+    std::optional<Socket::TcpInfo> Socket::getTcpInfo() const {
+        return std::nullopt;
+    }
+#else
+    // glibc's tcp_info stops at tcpi_total_retrans, the kernel one goes on up to the delivery rate
+    struct TcpInfoExtended {
+        tcp_info base;
+        uint64_t pacingRate;
+        uint64_t maxPacingRate;
+        uint64_t bytesAcked;
+        uint64_t bytesReceived;
+        uint32_t segmentsOut;
+        uint32_t segmentsIn;
+        uint32_t notSentBytes;
+        uint32_t minRtt;
+        uint32_t dataSegmentsIn;
+        uint32_t dataSegmentsOut;
+        uint64_t deliveryRate;
+    };
+
+    std::optional<Socket::TcpInfo> Socket::getTcpInfo() const {
+        if (m_sockfd < 0 || m_domain == Domain::Unix || m_type != Type::Stream)
+            return std::nullopt;
+
+        TcpInfoExtended info{};
+        socklen_t optlen = sizeof(info);
+        if (getsockopt(m_sockfd, IPPROTO_TCP, TCP_INFO, &info, &optlen) < 0)
+            return std::nullopt;
+
+        TcpInfo sample;
+        sample.rtt = std::chrono::microseconds(info.base.tcpi_rtt);
+        sample.rttVariance = std::chrono::microseconds(info.base.tcpi_rttvar);
+        sample.retransmits = info.base.tcpi_total_retrans;
+        sample.congestionWindow = info.base.tcpi_snd_cwnd;
+        sample.unacked = info.base.tcpi_unacked;
+        // older kernels copy a shorter struct
+        if (optlen >= offsetof(TcpInfoExtended, deliveryRate) + sizeof(info.deliveryRate))
+            sample.deliveryRate = info.deliveryRate;
+        return sample;
+    }
+#endif
+
+#ifdef _WIN32
+    Socket& Socket::setTimestamping(bool enable /*= true*/) {
+        throw std::runtime_error("SO_TIMESTAMPING is not supported on this platform");
+    }
+
+    bool Socket::collectTransmitTimestamps(uint32_t lastByte, Timestamp& transmitted, Timestamp& acknowledged) {
+        return false;
+    }
+
+    int Socket::receiveStamped(char* buffer, size_t len) {
+        return ::recv(m_sockfd, buffer, len, 0);
+    }
+#else
+    Socket& Socket::setTimestamping(bool enable /*= true*/) {
+        // TSONLY keeps the payload out of the error queue, OPT_ID numbers tx stamps by byte offset
+        int flags = enable ? SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_TX_ACK |
+            SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY : 0;
+        setIntOption(m_sockfd, SOL_SOCKET, SO_TIMESTAMPING, flags, "SO_TIMESTAMPING");
+        m_timestamping = enable;
+        return *this;
+    }
+
+    bool Socket::collectTransmitTimestamps(uint32_t lastByte, Timestamp& transmitted, Timestamp& acknowledged) {
+        drainErrorQueue();
+
+        // keys wrap after 4GB, a stamp counts once its key reached lastByte
+        auto reached = [lastByte](const TransmitStamp& stamp) {
+            return stamp.time != Timestamp{} && static_cast<int32_t>(stamp.key - lastByte) >= 0;
+        };
+        if (transmitted == Timestamp{} && reached(m_transmitted))
+            transmitted = m_transmitted.time;
+        if (acknowledged == Timestamp{} && reached(m_acknowledged))
+            acknowledged = m_acknowledged.time;
+        return transmitted != Timestamp{} && acknowledged != Timestamp{};
+    }
+
+    int Socket::receiveStamped(char* buffer, size_t len) {
+        iovec vector{ buffer, len };
+        char control[CMSG_SPACE(sizeof(scm_timestamping))];
+        msghdr message{};
+        message.msg_iov = &vector;
+        message.msg_iovlen = 1;
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+
+        auto bytesRead = ::recvmsg(m_sockfd, &message, 0);
+        if (bytesRead <= 0 || m_receiveTimestamp != Timestamp{})
+            return bytesRead;
+
+        for (cmsghdr* entry = CMSG_FIRSTHDR(&message); entry != nullptr; entry = CMSG_NXTHDR(&message, entry)) {
+            if (entry->cmsg_level == SOL_SOCKET && entry->cmsg_type == SCM_TIMESTAMPING) {
+                auto& stamp = reinterpret_cast<const scm_timestamping*>(CMSG_DATA(entry))->ts[0];
+                m_receiveTimestamp = toTimestamp(stamp);
+            }
+        }
+        return bytesRead;
+    }
+#endif
+
+    Socket& Socket::applyProfile(const Profile& profile, bool listener /*= false*/) {
+        bool tcp = m_domain != Domain::Unix;
+
+        if (listener) {
+            if (!tcp)
+                return *this;
+            if (profile.deferAccept)
+                setDeferAccept(*profile.deferAccept);
+            if (profile.fastOpenQueue)
+                setFastOpen(*profile.fastOpenQueue);
+
+            // accepted tcp sockets start out as a copy of the listener, so these cost one call instead of one per client
+            if (profile.sendBufferSize)
+                setSendBufferSize(*profile.sendBufferSize);
+            if (profile.receiveBufferSize)
+                setReceiveBufferSize(*profile.receiveBufferSize);
+            if (profile.noDelay)
+                setNoDelay(*profile.noDelay);
+            if (profile.quickAck)
+                setQuickAck(*profile.quickAck);
+            return *this;
+        }
+
+        if (profile.sendBufferSize)
+            setSendBufferSize(*profile.sendBufferSize);
+        if (profile.receiveBufferSize)
+            setReceiveBufferSize(*profile.receiveBufferSize);
+        if (profile.busyPoll)
+            setBusyPoll(*profile.busyPoll);
+        if (!tcp)
+            return *this;
+
+        if (profile.noDelay)
+            setNoDelay(*profile.noDelay);
+        if (profile.quickAck)
+            setQuickAck(*profile.quickAck);
+        if (profile.userTimeout)
+            setUserTimeout(*profile.userTimeout);
+        if (profile.zeroCopyThreshold)
+            setZeroCopy(*profile.zeroCopyThreshold);
+        if (profile.timestamping)
+            setTimestamping(*profile.timestamping);
+        return *this;
+    }
+
+    Socket::Profile Socket::clientProfile(const Profile& profile) const {
+        Profile client = profile;
+        if (m_domain == Domain::Unix)
+            return client;
+
+        client.sendBufferSize.reset();
+        client.receiveBufferSize.reset();
+        client.noDelay.reset();
+        client.quickAck.reset();
+        return client;
+    }
+
     Socket::Error Socket::getLastError() {
 #ifdef _WIN32
         int error = WSAGetLastError();
@@ -431,52 +1165,109 @@ namespace Network {
         return getErrorString(getLastError());
     }
 
-    bool Socket::waitForData(const std::chrono::seconds & secs, const std::chrono::microseconds & microsecs)
+    Socket::Deadline Socket::retryDeadline(size_t maxRetryCount) const
+    {
+        auto ladder = std::chrono::milliseconds(10 * ((size_t(1) << std::min<size_t>(maxRetryCount, 16)) - 1));
+        return Deadline::stalledFor(std::max<std::chrono::milliseconds>(ladder, std::chrono::seconds(m_timeout)));
+    }
+
+#ifdef _WIN32
+    using PollDescriptor = WSAPOLLFD;
+#else
+    using PollDescriptor = pollfd;
+#endif
+
+    // poll() semantics, a negative timeout waits forever, ppoll keeps nanosecond precision on linux
+    static int pollDescriptors(PollDescriptor* descriptors, size_t count, const std::chrono::nanoseconds& timeout)
+    {
+#ifdef _WIN32
+        int timeoutMilisecs = timeout.count() < 0 ? -1 : static_cast<int>(std::min<int64_t>(
+            std::chrono::ceil<std::chrono::milliseconds>(timeout).count(), INT32_MAX));
+        return WSAPoll(descriptors, static_cast<ULONG>(count), timeoutMilisecs);
+#else
+        if (timeout.count() < 0)
+            return ::ppoll(descriptors, count, nullptr, nullptr);
+
+        auto secs = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+        timespec timeoutVal{
+            static_cast<time_t>(secs.count()),
+            static_cast<long>((timeout - secs).count())
+        };
+        return ::ppoll(descriptors, count, &timeoutVal, nullptr);
+#endif
+    }
+
+    bool Socket::waitReady(bool forWrite, const Deadline& deadline)
+    {
+        return waitEvents(forWrite ? POLLOUT : POLLIN, deadline);
+    }
+
+    bool Socket::waitEvents(short events, const Deadline& deadline)
+    {
+        while (true) {
+            // a passed deadline still gets one non-blocking poll
+            auto left = std::chrono::nanoseconds(-1);
+            if (deadline.at != Deadline::Clock::time_point::max())
+                left = std::max<std::chrono::nanoseconds>(deadline.at - Deadline::Clock::now(), std::chrono::nanoseconds(0));
+
+            PollDescriptor descriptor{ m_sockfd, events, 0 };
+            int result = pollDescriptors(&descriptor, 1, left);
+
+            // a queued tx timestamp or zero copy completion raises POLLERR too, that's not the socket being ready
+            if (result > 0 && usesErrorQueue() && events != 0 && descriptor.revents == POLLERR && drainErrorQueue() > 0)
+                continue;
+
+            // errors and hangups count as ready, the next read/write reports them
+            if (result > 0)
+                return true;
+            if (result == 0)
+                return false;
+            if (getLastError() != Error::Interrupted)
+                throw std::runtime_error("Poll failed: " + getLastErrorString());
+        }
+    }
+
+    bool Socket::waitForData()
     {
         if (m_sockfd < 0) {
             throw std::runtime_error("Client socket is not connected: " +
                 getLastErrorString());
         }
 
-#ifdef _WIN32
-        u_long bytesAvailable = 0;
-        if (ioctlsocket(m_sockfd, FIONREAD, &bytesAvailable) == SOCKET_ERROR) {
-            throw std::runtime_error("Failed to check available data");
-        }
-#else
-        int bytesAvailable = 0;
-        if (ioctl(m_sockfd, FIONREAD, &bytesAvailable) == -1) {
-            throw std::runtime_error("Failed to check available data: " +
+        return waitEvents(POLLIN, Deadline{});
+    }
+
+    bool Socket::waitForData(const std::chrono::seconds & secs, const std::chrono::microseconds & microsecs)
+    {
+        if (m_sockfd < 0) {
+            throw std::runtime_error("Client socket is not connected: " +
                 getLastErrorString());
         }
-#endif
-
-        if (bytesAvailable > 0)
-            return true;
 
-        fd_set readSet;
-        FD_ZERO(&readSet);
-        FD_SET(m_sockfd, &readSet);
+        return waitEvents(POLLIN, Deadline::after(secs + microsecs));  // True if data available
+    }
 
-        timeval timeoutVal{
-            static_cast<long>(secs.count()),
-            static_cast<long>(microsecs.count())
-        };
+    size_t Socket::waitForData(std::span<Socket* const> sockets, std::vector<size_t>& ready,
+        const std::chrono::nanoseconds& timeout)
+    {
+        ready.clear();
 
-#ifdef _WIN32
-        int result = select(0, &readSet, nullptr, nullptr, &timeoutVal);
-#else
-        // On Unix systems, first parameter is highest fd + 1
-        int result = select(m_sockfd + 1, &readSet, nullptr, nullptr, &timeoutVal);
-#endif
+        // closed sockets have a negative handle which poll skips
+        std::vector<PollDescriptor> descriptors(sockets.size());
+        for (size_t i = 0; i < sockets.size(); i++)
+            descriptors[i] = PollDescriptor{ sockets[i] ? sockets[i]->m_sockfd : Handle(-1), POLLIN, 0 };
 
+        int result = pollDescriptors(descriptors.data(), descriptors.size(), timeout);
         if (result < 0) {
             if (getLastError() == Error::Interrupted)
-                return false;  // Interrupted by signal
-            throw std::runtime_error("Select failed: " + getLastErrorString());
+                return 0;
+            throw std::runtime_error("Poll failed: " + getLastErrorString());
         }
 
-        return result > 0;  // True if data available
+        for (size_t i = 0; i < descriptors.size() && ready.size() < static_cast<size_t>(result); i++)
+            if (descriptors[i].revents != 0)
+                ready.push_back(i);
+        return ready.size();
     }
 
     Socket& Socket::setTimeout(const std::chrono::seconds & timeout) {
@@ -0,0 +1,210 @@
+#include "../include/TimerWheel.h"
+
+TimerWheel::TimerWheel(WorkStealingPool& pool, std::chrono::milliseconds resolution /*= s_defaultResolution*/) :
+    m_pool(pool), m_resolution(std::max(resolution, std::chrono::milliseconds(1)))
+{
+    m_slots.fill(s_none);
+}
+
+TimerWheel::~TimerWheel()
+{
+    stop();
+}
+
+void TimerWheel::start()
+{
+    if (m_shouldRun.exchange(true))
+        return;
+    m_thread = std::thread(&TimerWheel::loop, this);
+}
+
+void TimerWheel::stop()
+{
+    if (!m_shouldRun.exchange(false))
+        return;
+    {
+        std::lock_guard lock(m_mutex);
+        m_wakeup.notify_one();
+    }
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+uint64_t TimerWheel::currentTick() const
+{
+    return static_cast<uint64_t>((Clock::now() - m_start) / m_resolution);
+}
+
+// the next level 0 slot holding a timer, or the next wrap, higher levels only move down when it wraps
+uint64_t TimerWheel::nextTick() const
+{
+    for (uint64_t tick = m_now + 1; tick <= ((m_now >> s_levelBits) + 1) << s_levelBits; tick++) {
+        if (m_slots[tick & (s_slotsPerLevel - 1)] != s_none)
+            return tick;
+    }
+    return ((m_now >> s_levelBits) + 1) << s_levelBits;
+}
+
+void TimerWheel::link(uint32_t index)
+{
+    auto& node = m_nodes[index];
+    uint64_t delta = node.expiry - m_now;
+
+    size_t level = 0;
+    while (level + 1 < s_levelCount && delta >= (uint64_t(1) << (s_levelBits * (level + 1))))
+        level++;
+
+    node.slot = static_cast<uint32_t>(level * s_slotsPerLevel +
+        ((node.expiry >> (s_levelBits * level)) & (s_slotsPerLevel - 1)));
+    node.previous = s_none;
+    node.next = m_slots[node.slot];
+    if (node.next != s_none)
+        m_nodes[node.next].previous = index;
+    m_slots[node.slot] = index;
+}
+
+void TimerWheel::unlink(uint32_t index)
+{
+    auto& node = m_nodes[index];
+    if (node.previous != s_none)
+        m_nodes[node.previous].next = node.next;
+    else
+        m_slots[node.slot] = node.next;
+    if (node.next != s_none)
+        m_nodes[node.next].previous = node.previous;
+    node.slot = s_none;
+}
+
+void TimerWheel::release(uint32_t index)
+{
+    auto& node = m_nodes[index];
+    node.generation++;
+    node.callback = nullptr;
+    node.next = m_free;
+    m_free = index;
+    m_armed--;
+}
+
+// moves the slot the wheel just reached one level down, its timers are now close enough for it
+void TimerWheel::cascade(size_t level)
+{
+    size_t slot = level * s_slotsPerLevel + ((m_now >> (s_levelBits * level)) & (s_slotsPerLevel - 1));
+    uint32_t index = std::exchange(m_slots[slot], s_none);
+    while (index != s_none) {
+        uint32_t next = m_nodes[index].next;
+        link(index);
+        index = next;
+    }
+}
+
+void TimerWheel::advance(uint64_t target, std::vector<Callback>& expired)
+{
+    if (m_armed == 0) {
+        m_now = std::max(m_now, target);
+        return;
+    }
+
+    while (m_now < target) {
+        m_now++;
+
+        for (size_t level = 1; level < s_levelCount; level++) {
+            if ((m_now & ((uint64_t(1) << (s_levelBits * level)) - 1)) != 0)
+                break;
+            cascade(level);
+        }
+
+        uint32_t index = std::exchange(m_slots[m_now & (s_slotsPerLevel - 1)], s_none);
+        while (index != s_none) {
+            uint32_t next = m_nodes[index].next;
+            m_nodes[index].slot = s_none;
+            expired.push_back(std::move(m_nodes[index].callback));
+            release(index);
+            index = next;
+        }
+    }
+}
+
+TimerWheel::Id TimerWheel::arm(std::chrono::milliseconds timeout, Callback callback)
+{
+    std::lock_guard lock(m_mutex);
+
+    // an empty wheel has nothing to cascade, it can jump straight to now
+    if (m_armed == 0)
+        m_now = std::max(m_now, currentTick());
+
+    uint32_t index = m_free;
+    if (index != s_none) {
+        m_free = m_nodes[index].next;
+    }
+    else {
+        index = static_cast<uint32_t>(m_nodes.size());
+        m_nodes.emplace_back();
+    }
+
+    // counted from the tick in progress, plus one so a timer never fires early, the loop may lag behind it
+    uint64_t ticks = (std::max(timeout, std::chrono::milliseconds(0)) + m_resolution - std::chrono::milliseconds(1)) / m_resolution;
+    uint64_t now = std::max(m_now, currentTick());
+    auto& node = m_nodes[index];
+    node.expiry = now + 1 + std::min<uint64_t>(ticks, s_maxTicks - 2 - (now - m_now));
+    node.callback = std::move(callback);
+    link(index);
+    m_armed++;
+
+    if (node.expiry < m_sleepUntil)
+        m_wakeup.notify_one();
+    return Id{ index, node.generation };
+}
+
+bool TimerWheel::cancel(Id& id)
+{
+    auto current = std::exchange(id, Id{});
+    if (!current.valid())
+        return false;
+
+    std::lock_guard lock(m_mutex);
+    if (current.index >= m_nodes.size())
+        return false;
+
+    auto& node = m_nodes[current.index];
+    if (node.generation != current.generation || node.slot == s_none)
+        return false;
+
+    unlink(current.index);
+    release(current.index);
+    return true;
+}
+
+size_t TimerWheel::size()
+{
+    std::lock_guard lock(m_mutex);
+    return m_armed;
+}
+
+void TimerWheel::loop()
+{
+    std::vector<Callback> expired;
+    std::unique_lock lock(m_mutex);
+
+    while (m_shouldRun.load()) {
+        advance(currentTick(), expired);
+
+        if (!expired.empty()) {
+            lock.unlock();
+            for (auto& callback : expired)
+                m_pool.pushTask(std::move(callback));
+            expired.clear();
+            lock.lock();
+            continue;
+        }
+
+        if (m_armed == 0) {
+            m_sleepUntil = UINT64_MAX;
+            m_wakeup.wait(lock);
+        }
+        else {
+            m_sleepUntil = nextTick();
+            m_wakeup.wait_until(lock, m_start + m_sleepUntil * m_resolution);
+        }
+        m_sleepUntil = 0;
+    }
+}
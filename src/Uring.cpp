@@ -0,0 +1,650 @@
+#include "../include/Uring.h"
+
+#ifndef _WIN32
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+#endif
+
+#ifdef _WIN32
+
+Uring::Uring(WorkStealingPool& pool) : m_pool(pool) {
+    throw std::runtime_error("io_uring backend is not supported on this platform");
+}
+
+Uring::~Uring() {}
+void Uring::start() {}
+void Uring::stop() {}
+void Uring::setupRings() {}
+void Uring::setupBuffers() {}
+void Uring::probeReceive() {}
+void Uring::release() {}
+void* Uring::getEntry(std::unique_lock<std::mutex>& submitLock) { return nullptr; }
+void Uring::submit(std::unique_lock<std::mutex>& submitLock) {}
+void Uring::track(Operation* op) {}
+void Uring::finish(Operation* op) {}
+void Uring::prepareAccept(Operation* op) {}
+void Uring::prepareReceive(Operation* op) {}
+void Uring::cancelOperation(Operation* op) {}
+void Uring::recycleBuffer(uint16_t bufferId) {}
+void Uring::complete(uint64_t userData, int result, uint32_t flags, std::vector<std::function<void()>>& ready) {}
+void Uring::loop() {}
+void Uring::asyncWait(Network::Socket::Handle handle, Reactor::Event event, WaitCallback callback) {}
+void Uring::asyncWait(Network::Socket::Handle handle, Reactor::Event event,
+    Clock::time_point deadline, WaitCallback callback) {}
+void Uring::asyncAccept(Network::Socket::Handle listenHandle, AcceptCallback callback) {}
+void Uring::asyncReceive(Network::Socket::Handle handle, ReceiveCallback callback, DoneCallback done) {}
+void Uring::asyncSend(Network::Socket::Handle handle, const std::vector<std::string_view>& buffers,
+    SendCallback callback) {}
+void Uring::cancel(Network::Socket::Handle handle) {}
+
+#else
+
+static constexpr uint64_t s_ignoreTag = 0; //link timeouts and cancel requests
+static constexpr uint64_t s_wakeTag = 1;
+
+static int setupRing(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int enterRing(int handle, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, handle, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+template<typename T>
+static T loadAcquire(T* value) {
+    return std::atomic_ref<T>(*value).load(std::memory_order_acquire);
+}
+
+template<typename T>
+static void storeRelease(T* value, T newValue) {
+    std::atomic_ref<T>(*value).store(newValue, std::memory_order_release);
+}
+
+Uring::Uring(WorkStealingPool& pool) : m_pool(pool)
+{
+    try {
+        setupRings();
+        setupBuffers();
+        probeReceive();
+    }
+    catch (...) {
+        release();
+        throw;
+    }
+}
+
+Uring::~Uring()
+{
+    stop();
+    release();
+
+    // the ring is gone, nothing can complete anymore
+    for (auto& [handle, operations] : m_operations)
+        for (auto* op : operations)
+            delete op;
+    m_operations.clear();
+}
+
+void Uring::setupRings()
+{
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CLAMP;
+
+    m_ringHandle = setupRing(s_queueDepth, &params);
+    if (m_ringHandle < 0) {
+        throw std::runtime_error("Failed to create io_uring instance: " +
+            Network::Socket::getLastErrorString());
+    }
+    if (!(params.features & IORING_FEAT_NODROP)) {
+        throw std::runtime_error("io_uring backend requires a newer kernel");
+    }
+
+    m_submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    m_completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMapping = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMapping)
+        m_submissionRingSize = m_completionRingSize = std::max(m_submissionRingSize, m_completionRingSize);
+
+    m_submissionRing = mmap(nullptr, m_submissionRingSize, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, m_ringHandle, IORING_OFF_SQ_RING);
+    if (m_submissionRing == MAP_FAILED) {
+        m_submissionRing = nullptr;
+        throw std::runtime_error("Failed to map io_uring submission ring");
+    }
+
+    if (singleMapping)
+        m_completionRing = m_submissionRing;
+    else {
+        m_completionRing = mmap(nullptr, m_completionRingSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, m_ringHandle, IORING_OFF_CQ_RING);
+        if (m_completionRing == MAP_FAILED) {
+            m_completionRing = nullptr;
+            throw std::runtime_error("Failed to map io_uring completion ring");
+        }
+    }
+
+    m_submissionEntriesSize = params.sq_entries * sizeof(io_uring_sqe);
+    m_submissionEntries = mmap(nullptr, m_submissionEntriesSize, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, m_ringHandle, IORING_OFF_SQES);
+    if (m_submissionEntries == MAP_FAILED) {
+        m_submissionEntries = nullptr;
+        throw std::runtime_error("Failed to map io_uring submission entries");
+    }
+
+    auto* submission = static_cast<char*>(m_submissionRing);
+    m_submissionHead = reinterpret_cast<uint32_t*>(submission + params.sq_off.head);
+    m_submissionTail = reinterpret_cast<uint32_t*>(submission + params.sq_off.tail);
+    m_submissionMask = *reinterpret_cast<uint32_t*>(submission + params.sq_off.ring_mask);
+    m_submissionEntryCount = params.sq_entries;
+    m_localTail = *m_submissionTail;
+
+    // entries are always used in ring order, so the index array is the identity
+    auto* indices = reinterpret_cast<uint32_t*>(submission + params.sq_off.array);
+    for (uint32_t i = 0; i < params.sq_entries; i++)
+        indices[i] = i;
+
+    auto* completion = static_cast<char*>(m_completionRing);
+    m_completionHead = reinterpret_cast<uint32_t*>(completion + params.cq_off.head);
+    m_completionTail = reinterpret_cast<uint32_t*>(completion + params.cq_off.tail);
+    m_completionMask = *reinterpret_cast<uint32_t*>(completion + params.cq_off.ring_mask);
+    m_completionEntries = completion + params.cq_off.cqes;
+}
+
+void Uring::setupBuffers()
+{
+    m_buffers.resize(static_cast<size_t>(s_bufferCount) * s_bufferSize);
+
+    // the ring thread isn't running yet, so the completion is reaped right here
+    std::unique_lock<std::mutex> submitLock(m_submitMutex);
+    auto* entry = static_cast<io_uring_sqe*>(getEntry(submitLock));
+    entry->opcode = IORING_OP_PROVIDE_BUFFERS;
+    entry->fd = s_bufferCount;
+    entry->addr = reinterpret_cast<uint64_t>(m_buffers.data());
+    entry->len = s_bufferSize;
+    entry->buf_group = s_bufferGroup;
+    entry->user_data = s_ignoreTag;
+    storeRelease(m_submissionTail, m_localTail);
+
+    if (enterRing(m_ringHandle, 1, 1, IORING_ENTER_GETEVENTS) < 0) {
+        throw std::runtime_error("Failed to provide io_uring receive buffers: " +
+            Network::Socket::getLastErrorString());
+    }
+
+    uint32_t head = *m_completionHead;
+    int result = static_cast<io_uring_cqe*>(m_completionEntries)[head & m_completionMask].res;
+    storeRelease(m_completionHead, head + 1);
+    if (result < 0) {
+        throw std::runtime_error("Failed to provide io_uring receive buffers: " +
+            Network::Socket::getErrorString(static_cast<Network::Socket::Error>(-result)));
+    }
+}
+
+void Uring::probeReceive()
+{
+    // kernels before 6.0 set the ring up fine and only reject multishot receives one by one,
+    // so one is tried here on a socket whose peer is already gone, it completes right away with the end of stream
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) < 0) {
+        throw std::runtime_error("Failed to create io_uring probe sockets: " +
+            Network::Socket::getLastErrorString());
+    }
+    ::close(pair[1]);
+
+    std::unique_lock<std::mutex> submitLock(m_submitMutex);
+    auto* entry = static_cast<io_uring_sqe*>(getEntry(submitLock));
+    entry->opcode = IORING_OP_RECV;
+    entry->fd = pair[0];
+    entry->flags = IOSQE_BUFFER_SELECT;
+    entry->buf_group = s_bufferGroup;
+    entry->ioprio = IORING_RECV_MULTISHOT;
+    entry->user_data = s_ignoreTag;
+    storeRelease(m_submissionTail, m_localTail);
+
+    int entered = enterRing(m_ringHandle, 1, 1, IORING_ENTER_GETEVENTS);
+    ::close(pair[0]);
+    if (entered < 0) {
+        throw std::runtime_error("Failed to probe io_uring multishot receive: " +
+            Network::Socket::getLastErrorString());
+    }
+
+    uint32_t head = *m_completionHead;
+    auto& completion = static_cast<io_uring_cqe*>(m_completionEntries)[head & m_completionMask];
+    int result = completion.res;
+    uint32_t flags = completion.flags;
+    storeRelease(m_completionHead, head + 1);
+    submitLock.unlock();
+
+    if (flags & IORING_CQE_F_BUFFER)
+        recycleBuffer(static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT));
+    if (result == -EINVAL)
+        throw std::runtime_error("io_uring backend requires multishot receive (linux 6.0+)");
+}
+
+void Uring::release()
+{
+    if (m_submissionEntries)
+        munmap(m_submissionEntries, m_submissionEntriesSize);
+    if (m_completionRing && m_completionRing != m_submissionRing)
+        munmap(m_completionRing, m_completionRingSize);
+    if (m_submissionRing)
+        munmap(m_submissionRing, m_submissionRingSize);
+    if (m_ringHandle >= 0)
+        ::close(m_ringHandle);
+
+    m_submissionEntries = m_completionRing = m_submissionRing = nullptr;
+    m_ringHandle = -1;
+}
+
+void Uring::start()
+{
+    if (m_shouldRun.exchange(true))
+        return;
+    m_thread = std::thread(&Uring::loop, this);
+}
+
+void Uring::stop()
+{
+    if (!m_shouldRun.exchange(false))
+        return;
+
+    {
+        std::unique_lock<std::mutex> submitLock(m_submitMutex);
+        auto* entry = static_cast<io_uring_sqe*>(getEntry(submitLock));
+        entry->opcode = IORING_OP_NOP;
+        entry->user_data = s_wakeTag;
+        submit(submitLock);
+    }
+
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void* Uring::getEntry(std::unique_lock<std::mutex>& submitLock)
+{
+    if (m_localTail - loadAcquire(m_submissionHead) >= m_submissionEntryCount) {
+        submit(submitLock);
+        if (m_localTail - loadAcquire(m_submissionHead) >= m_submissionEntryCount)
+            throw std::runtime_error("io_uring submission queue is full");
+    }
+
+    auto* entry = static_cast<io_uring_sqe*>(m_submissionEntries) + (m_localTail & m_submissionMask);
+    std::memset(entry, 0, sizeof(io_uring_sqe));
+    m_localTail++;
+    return entry;
+}
+
+void Uring::submit(std::unique_lock<std::mutex>&)
+{
+    storeRelease(m_submissionTail, m_localTail);
+
+    // whatever the kernel didn't take stays queued and goes out with the next submission
+    unsigned pending = m_localTail - loadAcquire(m_submissionHead);
+    while (pending > 0) {
+        int submitted = enterRing(m_ringHandle, pending, 0, 0);
+        if (submitted >= 0)
+            break;
+        if (errno == EINTR)
+            continue;
+        if (errno == EAGAIN || errno == EBUSY) {
+            std::this_thread::yield();
+            continue;
+        }
+        throw std::runtime_error("io_uring submission failed: " +
+            Network::Socket::getLastErrorString());
+    }
+}
+
+void Uring::track(Operation* op)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_operations[op->handle].push_back(op);
+}
+
+void Uring::finish(Operation* op)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_operations.find(op->handle);
+        if (it != m_operations.end()) {
+            auto& operations = it->second;
+            operations.erase(std::remove(operations.begin(), operations.end(), op), operations.end());
+            if (operations.empty())
+                m_operations.erase(it);
+        }
+    }
+    delete op;
+}
+
+void Uring::asyncWait(Network::Socket::Handle handle, Reactor::Event event, WaitCallback callback)
+{
+    asyncWait(handle, event, Clock::time_point::max(), std::move(callback));
+}
+
+void Uring::asyncWait(Network::Socket::Handle handle, Reactor::Event event,
+    Clock::time_point deadline, WaitCallback callback)
+{
+    if (handle < 0)
+        throw std::runtime_error("Cannot wait on a closed socket");
+
+    auto* op = new Operation{};
+    op->type = Operation::Type::Wait;
+    op->handle = handle;
+    op->waitCallback = std::move(callback);
+    track(op);
+
+    bool hasDeadline = deadline != Clock::time_point::max();
+    if (hasDeadline) {
+        auto remaining = std::max(deadline - Clock::now(), Clock::duration::zero());
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(remaining);
+        op->timeout[0] = seconds.count();
+        op->timeout[1] = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - seconds).count();
+    }
+
+    std::unique_lock<std::mutex> submitLock(m_submitMutex);
+
+    // a link must not be split across two submissions
+    if (m_submissionEntryCount - (m_localTail - loadAcquire(m_submissionHead)) < 2)
+        submit(submitLock);
+
+    auto* poll = static_cast<io_uring_sqe*>(getEntry(submitLock));
+    poll->opcode = IORING_OP_POLL_ADD;
+    poll->fd = handle;
+    poll->poll32_events = event == Reactor::Event::Read ? (POLLIN | POLLRDHUP) : POLLOUT;
+    poll->user_data = reinterpret_cast<uint64_t>(op);
+
+    if (hasDeadline) {
+        poll->flags |= IOSQE_IO_LINK;
+        auto* timeout = static_cast<io_uring_sqe*>(getEntry(submitLock));
+        timeout->opcode = IORING_OP_LINK_TIMEOUT;
+        timeout->fd = -1;
+        timeout->addr = reinterpret_cast<uint64_t>(op->timeout);
+        timeout->len = 1;
+        timeout->user_data = s_ignoreTag;
+    }
+
+    submit(submitLock);
+}
+
+void Uring::asyncAccept(Network::Socket::Handle listenHandle, AcceptCallback callback)
+{
+    auto* op = new Operation{};
+    op->type = Operation::Type::Accept;
+    op->handle = listenHandle;
+    op->acceptCallback = std::move(callback);
+    track(op);
+    prepareAccept(op);
+}
+
+void Uring::prepareAccept(Operation* op)
+{
+    std::unique_lock<std::mutex> submitLock(m_submitMutex);
+    auto* entry = static_cast<io_uring_sqe*>(getEntry(submitLock));
+    entry->opcode = IORING_OP_ACCEPT;
+    entry->fd = op->handle;
+    entry->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    entry->ioprio = IORING_ACCEPT_MULTISHOT;
+    entry->user_data = reinterpret_cast<uint64_t>(op);
+    submit(submitLock);
+}
+
+void Uring::asyncReceive(Network::Socket::Handle handle, ReceiveCallback callback, DoneCallback done)
+{
+    auto* op = new Operation{};
+    op->type = Operation::Type::Receive;
+    op->handle = handle;
+    op->receiveCallback = std::move(callback);
+    op->doneCallback = std::move(done);
+    track(op);
+    prepareReceive(op);
+}
+
+void Uring::prepareReceive(Operation* op)
+{
+    std::unique_lock<std::mutex> submitLock(m_submitMutex);
+    auto* entry = static_cast<io_uring_sqe*>(getEntry(submitLock));
+    entry->opcode = IORING_OP_RECV;
+    entry->fd = op->handle;
+    entry->flags = IOSQE_BUFFER_SELECT;
+    entry->buf_group = s_bufferGroup;
+    entry->ioprio = IORING_RECV_MULTISHOT;
+    entry->user_data = reinterpret_cast<uint64_t>(op);
+    submit(submitLock);
+}
+
+void Uring::asyncSend(Network::Socket::Handle handle, const std::vector<std::string_view>& buffers,
+    SendCallback callback)
+{
+    size_t count = std::count_if(buffers.begin(), buffers.end(),
+        [](std::string_view buffer) { return !buffer.empty(); });
+    if (count == 0) {
+        m_pool.pushTask([callback = std::move(callback)]() { callback(0); });
+        return;
+    }
+    if (count > m_submissionEntryCount)
+        throw std::runtime_error("Too many buffers for a single linked send");
+
+    auto* op = new Operation{};
+    op->type = Operation::Type::Send;
+    op->handle = handle;
+    op->sendCallback = std::move(callback);
+    op->pendingSends = count;
+    track(op);
+
+    std::unique_lock<std::mutex> submitLock(m_submitMutex);
+    if (m_submissionEntryCount - (m_localTail - loadAcquire(m_submissionHead)) < count)
+        submit(submitLock);
+
+    size_t prepared = 0;
+    for (auto buffer : buffers)
+    {
+        if (buffer.empty())
+            continue;
+
+        // a short or failed send cancels the rest of the chain, so the bytes can't reorder
+        auto* entry = static_cast<io_uring_sqe*>(getEntry(submitLock));
+        entry->opcode = IORING_OP_SEND;
+        entry->fd = handle;
+        entry->addr = reinterpret_cast<uint64_t>(buffer.data());
+        entry->len = static_cast<uint32_t>(buffer.size());
+        entry->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+        entry->user_data = reinterpret_cast<uint64_t>(op);
+        if (++prepared < count)
+            entry->flags |= IOSQE_IO_LINK;
+    }
+
+    submit(submitLock);
+}
+
+void Uring::cancelOperation(Operation* op)
+{
+    std::unique_lock<std::mutex> submitLock(m_submitMutex);
+    auto* entry = static_cast<io_uring_sqe*>(getEntry(submitLock));
+    entry->opcode = IORING_OP_ASYNC_CANCEL;
+    entry->fd = -1;
+    entry->addr = reinterpret_cast<uint64_t>(op);
+    entry->user_data = s_ignoreTag;
+    submit(submitLock);
+}
+
+void Uring::cancel(Network::Socket::Handle handle)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_operations.find(handle);
+        if (it == m_operations.end())
+            return;
+
+        // callbacks are released by the ring thread once the kernel reports the cancellation
+        for (auto* op : it->second)
+            op->cancelled = true;
+    }
+
+    std::unique_lock<std::mutex> submitLock(m_submitMutex);
+    auto* entry = static_cast<io_uring_sqe*>(getEntry(submitLock));
+    entry->opcode = IORING_OP_ASYNC_CANCEL;
+    entry->fd = handle;
+    entry->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_ALL;
+    entry->user_data = s_ignoreTag;
+    submit(submitLock);
+}
+
+void Uring::recycleBuffer(uint16_t bufferId)
+{
+    // queued only, the loop submits every recycled buffer of a batch at once
+    std::unique_lock<std::mutex> submitLock(m_submitMutex);
+    auto* entry = static_cast<io_uring_sqe*>(getEntry(submitLock));
+    entry->opcode = IORING_OP_PROVIDE_BUFFERS;
+    entry->fd = 1;
+    entry->addr = reinterpret_cast<uint64_t>(m_buffers.data() + static_cast<size_t>(bufferId) * s_bufferSize);
+    entry->len = s_bufferSize;
+    entry->off = bufferId;
+    entry->buf_group = s_bufferGroup;
+    entry->user_data = s_ignoreTag;
+    m_recycled = true;
+}
+
+void Uring::complete(uint64_t userData, int result, uint32_t flags,
+    std::vector<std::function<void()>>& ready)
+{
+    if (userData == s_ignoreTag || userData == s_wakeTag)
+        return;
+
+    auto* op = reinterpret_cast<Operation*>(userData);
+    bool more = flags & IORING_CQE_F_MORE;
+
+    switch (op->type)
+    {
+    case Operation::Type::Wait:
+        // the linked timeout cancels the poll when it fires
+        if (!op->cancelled)
+            ready.push_back([callback = std::move(op->waitCallback), isReady = result != -ECANCELED]() {
+                callback(isReady);
+            });
+        finish(op);
+        break;
+
+    case Operation::Type::Accept:
+        if (result >= 0) {
+            if (op->cancelled || !m_shouldRun.load())
+                ::close(result);
+            else
+                op->acceptCallback(result);
+        }
+        else if (result != -ECANCELED)
+            std::cerr << "Accept error: " << Network::Socket::getErrorString(
+                static_cast<Network::Socket::Error>(-result)) << std::endl;
+
+        if (!more) {
+            bool fatal = result == -EBADF || result == -EINVAL || result == -ENOTSOCK;
+            if (!op->cancelled && !fatal && m_shouldRun.load())
+                prepareAccept(op);
+            else
+                finish(op);
+        }
+        break;
+
+    case Operation::Type::Receive:
+        if (flags & IORING_CQE_F_BUFFER) {
+            auto bufferId = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+            if (result > 0 && !op->cancelled) {
+                // data that raced with a stop request is still delivered so no bytes are lost
+                bool keep = op->receiveCallback(m_buffers.data() + static_cast<size_t>(bufferId) * s_bufferSize, result);
+                if (!keep && !op->stopRequested) {
+                    op->stopRequested = true;
+                    cancelOperation(op);
+                }
+            }
+            recycleBuffer(bufferId);
+        }
+
+        if (result == 0 || (result < 0 && result != -ENOBUFS && result != -ECANCELED)) {
+            if (!op->cancelled && !op->stopRequested)
+                op->receiveCallback(nullptr, 0);
+            op->stopRequested = true;
+        }
+
+        if (!more) {
+            // running out of provided buffers ends the multishot request, it just needs rearming
+            if (result == -ENOBUFS && !op->cancelled && !op->stopRequested && m_shouldRun.load()) {
+                prepareReceive(op);
+                break;
+            }
+            if (!op->cancelled && op->doneCallback)
+                ready.push_back(std::move(op->doneCallback));
+            finish(op);
+        }
+        break;
+
+    case Operation::Type::Send:
+        if (result < 0) {
+            if (op->sendResult >= 0)
+                op->sendResult = result;
+        }
+        else if (op->sendResult >= 0)
+            op->sendResult += result;
+
+        if (--op->pendingSends == 0) {
+            if (!op->cancelled)
+                ready.push_back([callback = std::move(op->sendCallback), sent = op->sendResult]() {
+                    callback(sent);
+                });
+            finish(op);
+        }
+        break;
+    }
+}
+
+void Uring::loop()
+{
+    std::vector<std::function<void()>> ready;
+    auto* completions = static_cast<io_uring_cqe*>(m_completionEntries);
+
+    while (m_shouldRun.load())
+    {
+        if (enterRing(m_ringHandle, 0, 1, IORING_ENTER_GETEVENTS) < 0 &&
+            errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            std::cerr << "io_uring wait failed: " << Network::Socket::getLastErrorString() << std::endl;
+            break;
+        }
+
+        uint32_t head = *m_completionHead;
+        uint32_t tail = loadAcquire(m_completionTail);
+        for (; head != tail; head++)
+        {
+            auto& completion = completions[head & m_completionMask];
+            uint64_t userData = completion.user_data;
+            int result = completion.res;
+            uint32_t flags = completion.flags;
+            storeRelease(m_completionHead, head + 1);
+
+            try {
+                complete(userData, result, flags, ready);
+            }
+            catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+            }
+        }
+
+        if (std::exchange(m_recycled, false)) {
+            try {
+                std::unique_lock<std::mutex> submitLock(m_submitMutex);
+                submit(submitLock);
+            }
+            catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+            }
+        }
+
+        for (auto& task : ready)
+            m_pool.pushTask(std::move(task));
+        ready.clear();
+    }
+}
+
+#endif
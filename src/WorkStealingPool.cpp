@@ -0,0 +1,288 @@
+#include "../include/WorkStealingPool.h"
+
+namespace
+{
+    // the pool and worker the current thread belongs to, pushes from a worker skip the injection queue
+    thread_local WorkStealingPool* t_pool = nullptr;
+    thread_local void* t_worker = nullptr;
+}
+
+WorkStealingPool::Deque::Deque(int64_t capacity /*= 256*/)
+{
+    m_buffers.push_back(std::make_unique<Buffer>(capacity));
+    m_buffer.store(m_buffers.back().get(), std::memory_order_relaxed);
+}
+
+WorkStealingPool::Deque::Buffer* WorkStealingPool::Deque::grow(Buffer* buffer, int64_t top, int64_t bottom)
+{
+    auto grown = std::make_unique<Buffer>(buffer->capacity * 2);
+    for (int64_t i = top; i < bottom; i++)
+        grown->put(i, buffer->get(i));
+    m_buffers.push_back(std::move(grown));
+    m_buffer.store(m_buffers.back().get(), std::memory_order_release);
+    return m_buffers.back().get();
+}
+
+void WorkStealingPool::Deque::push(Task* task)
+{
+    int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+    int64_t top = m_top.load(std::memory_order_acquire);
+    Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+    if (bottom - top > buffer->capacity - 1)
+        buffer = grow(buffer, top, bottom);
+
+    buffer->put(bottom, task);
+    std::atomic_thread_fence(std::memory_order_release);
+    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+}
+
+WorkStealingPool::Task* WorkStealingPool::Deque::pop()
+{
+    int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+    Buffer* buffer = m_buffer.load(std::memory_order_relaxed);
+    m_bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = m_top.load(std::memory_order_relaxed);
+
+    if (top > bottom) {
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Task* task = buffer->get(bottom);
+    if (top == bottom) {
+        // last task, a thief may be after it too, whoever moves top first gets it
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            task = nullptr;
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return task;
+}
+
+WorkStealingPool::Task* WorkStealingPool::Deque::steal()
+{
+    int64_t top = m_top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = m_bottom.load(std::memory_order_acquire);
+    if (top >= bottom)
+        return nullptr;
+
+    Task* task = m_buffer.load(std::memory_order_acquire)->get(top);
+    if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr; // lost to the owner or another thief
+    return task;
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    shutdown();
+}
+
+void WorkStealingPool::init(size_t threadCount)
+{
+    if (m_active.exchange(true))
+        return;
+
+    threadCount = std::max<size_t>(threadCount, 1);
+    for (size_t i = 0; i < threadCount; i++) {
+        m_workers.push_back(std::make_unique<Worker>());
+        m_workers.back()->victimSeed = i * 0x9E3779B97F4A7C15ull + 1;
+    }
+    // every worker exists before the first one starts looking for victims
+    for (size_t i = 0; i < threadCount; i++)
+        m_workers[i]->thread = std::thread(&WorkStealingPool::workerLoop, this, i);
+}
+
+void WorkStealingPool::shutdown()
+{
+    if (!m_active.exchange(false))
+        return;
+
+    m_signal.fetch_add(1);
+    m_signal.notify_all();
+    for (auto& worker : m_workers) {
+        if (worker->thread.joinable())
+            worker->thread.join();
+    }
+
+    for (auto& worker : m_workers) {
+        delete worker->lifo.exchange(nullptr);
+        while (auto task = worker->deque.pop())
+            delete task;
+    }
+    std::lock_guard lock(m_injectionMutex);
+    for (auto task : m_injected)
+        delete task;
+    m_injected.clear();
+    m_injectedSize = 0;
+}
+
+bool WorkStealingPool::isWorkerThread() const
+{
+    return t_pool == this;
+}
+
+bool WorkStealingPool::pushTask(Task task)
+{
+    if (!m_active.load())
+        return false;
+
+    auto pushed = new Task(std::move(task));
+    if (t_pool == this) {
+        auto& worker = *static_cast<Worker*>(t_worker);
+        if (auto displaced = worker.lifo.exchange(pushed, std::memory_order_acq_rel))
+            worker.deque.push(displaced);
+    }
+    else {
+        std::lock_guard lock(m_injectionMutex);
+        m_injected.push_back(pushed);
+        m_injectedSize.fetch_add(1);
+    }
+
+    notify();
+    return true;
+}
+
+// a worker that is about to block in its task can't run what it just queued, a sleeping one has to look
+void WorkStealingPool::notify()
+{
+    m_signal.fetch_add(1);
+    if (m_sleeping.load() > 0)
+        m_signal.notify_one();
+}
+
+WorkStealingPool::Task* WorkStealingPool::popInjected()
+{
+    if (m_injectedSize.load(std::memory_order_relaxed) == 0)
+        return nullptr;
+
+    std::lock_guard lock(m_injectionMutex);
+    if (m_injected.empty())
+        return nullptr;
+    Task* task = m_injected.front();
+    m_injected.pop_front();
+    m_injectedSize.fetch_sub(1, std::memory_order_relaxed);
+    return task;
+}
+
+// deques first, a slot is only taken once no deque has anything, it would otherwise run on its owner next
+WorkStealingPool::Task* WorkStealingPool::steal(Worker& worker, size_t index)
+{
+    size_t count = m_workers.size();
+    if (count < 2)
+        return nullptr;
+
+    worker.victimSeed ^= worker.victimSeed << 13;
+    worker.victimSeed ^= worker.victimSeed >> 7;
+    worker.victimSeed ^= worker.victimSeed << 17;
+    size_t start = worker.victimSeed % count;
+
+    for (size_t i = 0; i < count; i++) {
+        size_t victim = (start + i) % count;
+        if (victim != index) {
+            if (auto task = m_workers[victim]->deque.steal())
+                return task;
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        size_t victim = (start + i) % count;
+        if (victim != index && m_workers[victim]->lifo.load(std::memory_order_relaxed) != nullptr) {
+            if (auto task = m_workers[victim]->lifo.exchange(nullptr, std::memory_order_acq_rel))
+                return task;
+        }
+    }
+    return nullptr;
+}
+
+WorkStealingPool::Task* WorkStealingPool::findTask(Worker& worker, size_t index, size_t tick)
+{
+    if (tick % s_injectionInterval == 0) {
+        if (auto task = popInjected()) {
+            worker.injectedCount.fetch_add(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+
+    if (worker.lifoStreak < s_maxLifoStreak) {
+        if (auto task = worker.lifo.exchange(nullptr, std::memory_order_acq_rel)) {
+            worker.lifoStreak++;
+            worker.lifoCount.fetch_add(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+    worker.lifoStreak = 0;
+
+    if (auto task = worker.deque.pop())
+        return task;
+
+    if (auto task = worker.lifo.exchange(nullptr, std::memory_order_acq_rel)) {
+        worker.lifoCount.fetch_add(1, std::memory_order_relaxed);
+        return task;
+    }
+
+    if (auto task = popInjected()) {
+        worker.injectedCount.fetch_add(1, std::memory_order_relaxed);
+        return task;
+    }
+
+    if (auto task = steal(worker, index)) {
+        worker.stolenCount.fetch_add(1, std::memory_order_relaxed);
+        return task;
+    }
+    return nullptr;
+}
+
+void WorkStealingPool::run(Worker& worker, Task* task)
+{
+    std::unique_ptr<Task> owned(task);
+    try {
+        (*owned)();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Task error: " << e.what() << std::endl;
+    }
+    worker.executed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void WorkStealingPool::workerLoop(size_t index)
+{
+    auto& worker = *m_workers[index];
+    t_pool = this;
+    t_worker = &worker;
+
+    size_t tick = 0;
+    while (m_active.load(std::memory_order_relaxed)) {
+        if (auto task = findTask(worker, index, tick++)) {
+            run(worker, task);
+            continue;
+        }
+
+        // announce the sleep before the last look, a push after it either shows up in that look
+        // or finds the sleeper and changes the signal it waits on
+        uint64_t seen = m_signal.load();
+        m_sleeping.fetch_add(1);
+        if (auto task = findTask(worker, index, tick++)) {
+            m_sleeping.fetch_sub(1);
+            run(worker, task);
+            continue;
+        }
+        if (m_active.load())
+            m_signal.wait(seen);
+        m_sleeping.fetch_sub(1);
+    }
+
+    t_pool = nullptr;
+    t_worker = nullptr;
+}
+
+WorkStealingPool::Stats WorkStealingPool::getStats() const
+{
+    Stats stats;
+    for (auto& worker : m_workers) {
+        stats.executed += worker->executed.load(std::memory_order_relaxed);
+        stats.lifo += worker->lifoCount.load(std::memory_order_relaxed);
+        stats.injected += worker->injectedCount.load(std::memory_order_relaxed);
+        stats.stolen += worker->stolenCount.load(std::memory_order_relaxed);
+    }
+    return stats;
+}